@@ -0,0 +1,284 @@
+// guard/alloc.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Подсчёт выделений памяти в тестах.
+//
+// Счётчики ведутся на поток. Сами замены глобальных operator new/delete
+// подключаются только в одной единице трансляции — той, где определён
+// макрос GUARD_TEST_ALLOC_HOOKS до подключения guard_main.h (обычно это
+// файл с GUARD_TEST_MAIN). Без замен счётчики остаются нулевыми, а
+// guard::alloc::enabled() возвращает false.
+
+namespace guard
+{
+    namespace alloc
+    {
+        struct Counters
+        {
+            // Число выделений и суммарно запрошенные байты
+            unsigned long long count = 0;
+            unsigned long long bytes = 0;
+            // Живые байты и их максимум; память, освобождённая в другом
+            // потоке, уменьшает счётчик того потока
+            long long live = 0;
+            long long peak = 0;
+        };
+
+        inline Counters &thread_counters()
+        {
+            static thread_local Counters counters;
+            return counters;
+        }
+
+        inline bool &enabled()
+        {
+            static bool flag = false;
+            return flag;
+        }
+
+        // Выделения внутри участка кода: разница счётчиков и пик
+        // живых байт относительно начала участка
+        class Scope
+        {
+        public:
+            Scope() : m_start(thread_counters())
+            {
+                thread_counters().peak = m_start.live;
+            }
+
+            ~Scope()
+            {
+                // Внешний участок должен видеть максимум и по вложенному
+                Counters &c = thread_counters();
+                if (m_start.peak > c.peak)
+                    c.peak = m_start.peak;
+            }
+
+            unsigned long long count() const
+            {
+                return thread_counters().count - m_start.count;
+            }
+
+            unsigned long long bytes() const
+            {
+                return thread_counters().bytes - m_start.bytes;
+            }
+
+            unsigned long long peak() const
+            {
+                const long long p = thread_counters().peak - m_start.live;
+                return p > 0 ? static_cast<unsigned long long>(p) : 0;
+            }
+
+        private:
+            Counters m_start;
+        };
+
+        // Участок, выделения в котором не учитываются: при выходе
+        // счётчики потока возвращаются к началу участка, будто участка
+        // не было (построение общих фикстур)
+        class Suspend
+        {
+        public:
+            Suspend() : m_saved(thread_counters())
+            {
+            }
+
+            ~Suspend()
+            {
+                thread_counters() = m_saved;
+            }
+
+            Suspend(const Suspend &) = delete;
+            Suspend &operator=(const Suspend &) = delete;
+
+        private:
+            Counters m_saved;
+        };
+
+        namespace detail
+        {
+            // Перед каждым блоком лежит заголовок с размером и смещением
+            // от начала блока malloc
+            struct Header
+            {
+                std::size_t size;
+                std::size_t offset;
+            };
+
+            inline void *allocate(std::size_t size, std::size_t align)
+            {
+                const std::size_t base_align = alignof(std::max_align_t);
+                if (align < base_align)
+                    align = base_align;
+                const std::size_t prefix = (sizeof(Header) + align - 1) / align * align;
+                const std::size_t slack = align > base_align ? align : 0;
+
+                char *base = static_cast<char *>(std::malloc(prefix + size + slack));
+                if (!base)
+                    return nullptr;
+
+                std::uintptr_t user = reinterpret_cast<std::uintptr_t>(base) + prefix;
+                if (slack)
+                    user = (user + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+                Header *h = reinterpret_cast<Header *>(user) - 1;
+                h->size = size;
+                h->offset = static_cast<std::size_t>(user - reinterpret_cast<std::uintptr_t>(base));
+
+                Counters &c = thread_counters();
+                ++c.count;
+                c.bytes += size;
+                c.live += static_cast<long long>(size);
+                if (c.live > c.peak)
+                    c.peak = c.live;
+                return reinterpret_cast<void *>(user);
+            }
+
+            inline void *allocate_or_throw(std::size_t size, std::size_t align)
+            {
+                for (;;)
+                {
+                    void *p = allocate(size, align);
+                    if (p)
+                        return p;
+                    std::new_handler handler = std::get_new_handler();
+                    if (!handler)
+                        throw std::bad_alloc();
+                    handler();
+                }
+            }
+
+            inline void deallocate(void *p) noexcept
+            {
+                if (!p)
+                    return;
+                const Header *h = static_cast<const Header *>(p) - 1;
+                thread_counters().live -= static_cast<long long>(h->size);
+                std::free(static_cast<char *>(p) - h->offset);
+            }
+
+            struct EnableTracking
+            {
+                EnableTracking()
+                {
+                    enabled() = true;
+                }
+            };
+        } // namespace detail
+    } // namespace alloc
+} // namespace guard
+
+#if defined(GUARD_TEST_ALLOC_HOOKS) && !defined(GUARD_TEST_ALLOC_HOOKS_DEFINED)
+#define GUARD_TEST_ALLOC_HOOKS_DEFINED
+
+static ::guard::alloc::detail::EnableTracking guard_alloc_enable_tracking;
+
+void *operator new(std::size_t size)
+{
+    return ::guard::alloc::detail::allocate_or_throw(size, 0);
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::guard::alloc::detail::allocate_or_throw(size, 0);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return ::guard::alloc::detail::allocate(size, 0);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return ::guard::alloc::detail::allocate(size, 0);
+}
+
+void operator delete(void *p) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void *p, std::size_t) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    return ::guard::alloc::detail::allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void *operator new[](std::size_t size, std::align_val_t align)
+{
+    return ::guard::alloc::detail::allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void *operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return ::guard::alloc::detail::allocate(size, static_cast<std::size_t>(align));
+}
+
+void *operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return ::guard::alloc::detail::allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    ::guard::alloc::detail::deallocate(p);
+}
+#endif
+#endif
@@ -0,0 +1,1279 @@
+// guard/bench.h
+#pragma once
+
+#include "env.h"
+#include "perf.h"
+#include "registry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace guard
+{
+    // ---------- барьеры для оптимизатора ----------
+
+#if defined(__GNUC__) || defined(__clang__)
+    // Заставляет компилятор считать, что значение прочитано
+    template <typename T>
+    inline void do_not_optimize(T const &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Значение прочитано и, возможно, изменено
+    template <typename T>
+    inline typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                                   (sizeof(T) <= sizeof(T *))>::type
+    do_not_optimize(T &value)
+    {
+#if defined(__clang__)
+        asm volatile("" : "+r,m"(value) : : "memory");
+#else
+        asm volatile("" : "+m,r"(value) : : "memory");
+#endif
+    }
+
+    template <typename T>
+    inline typename std::enable_if<!std::is_trivially_copyable<T>::value ||
+                                   (sizeof(T) > sizeof(T *))>::type
+    do_not_optimize(T &value)
+    {
+        asm volatile("" : "+m"(value) : : "memory");
+    }
+
+    // Все записи в память должны состояться до этой точки
+    inline void clobber_memory()
+    {
+        asm volatile("" : : : "memory");
+    }
+#else
+    namespace detail
+    {
+        inline void use_char_pointer(char const volatile *)
+        {
+        }
+    } // namespace detail
+
+    template <typename T>
+    inline void do_not_optimize(T const &value)
+    {
+        detail::use_char_pointer(&reinterpret_cast<char const volatile &>(value));
+        _ReadWriteBarrier();
+    }
+
+    inline void clobber_memory()
+    {
+        _ReadWriteBarrier();
+    }
+#endif
+
+    namespace bench
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Состояние одного замера. Тело бенчмарка крутит цикл
+        //   while (state.keep_running()) { ... }
+        // а раннер подбирает число итераций.
+        class State
+        {
+        public:
+            explicit State(std::uint64_t iterations)
+                : m_iterations(iterations), m_remaining(iterations)
+            {
+            }
+
+            // true ровно iterations() раз; таймер (и счётчики при
+            // --perf-counters) стартует при первом вызове и
+            // останавливается при последнем
+            bool keep_running()
+            {
+                if (m_remaining != 0)
+                {
+                    if (m_remaining-- == m_iterations)
+                        start_timing();
+                    return true;
+                }
+                if (!m_finished)
+                {
+                    stop_timing();
+                    m_finished = true;
+                }
+                return false;
+            }
+
+            std::uint64_t iterations() const
+            {
+                return m_iterations;
+            }
+
+            // Исключить из замера подготовку данных внутри цикла
+            void pause_timing()
+            {
+                stop_timing();
+            }
+
+            void resume_timing()
+            {
+                start_timing();
+            }
+
+            // Для пропускной способности: сколько элементов / байт
+            // обрабатывает одна итерация
+            void set_items_per_iteration(double items)
+            {
+                m_items_per_iteration = items;
+            }
+
+            void set_bytes_per_iteration(double bytes)
+            {
+                m_bytes_per_iteration = bytes;
+            }
+
+            double items_per_iteration() const
+            {
+                return m_items_per_iteration;
+            }
+
+            double bytes_per_iteration() const
+            {
+                return m_bytes_per_iteration;
+            }
+
+            bool finished() const
+            {
+                return m_finished;
+            }
+
+            double elapsed_ns() const
+            {
+                return std::chrono::duration<double, std::nano>(m_elapsed).count();
+            }
+
+            // Аппаратные счётчики за замеренную часть (пусты без
+            // --perf-counters или без доступа к счётчикам)
+            const perf::Counts &perf_counts() const
+            {
+                return m_perf;
+            }
+
+        private:
+            // Счётчики читаются снаружи интервала таймера, чтобы системный
+            // вызов не попадал в замер времени
+            void start_timing()
+            {
+                if (m_count_perf)
+                    m_perf_start = perf::thread_counts();
+                m_start = Clock::now();
+            }
+
+            void stop_timing()
+            {
+                m_elapsed += Clock::now() - m_start;
+                if (m_count_perf)
+                    m_perf += perf::thread_counts() - m_perf_start;
+            }
+
+            std::uint64_t m_iterations;
+            std::uint64_t m_remaining;
+            bool m_finished = false;
+            Clock::time_point m_start;
+            Clock::duration m_elapsed = Clock::duration::zero();
+            double m_items_per_iteration = 0;
+            double m_bytes_per_iteration = 0;
+            bool m_count_perf = perf::enabled();
+            perf::Counts m_perf_start;
+            perf::Counts m_perf;
+        };
+
+        using BenchFunc = void (*)(State &);
+
+        struct Benchmark
+        {
+            const char *name;
+            const char *file;
+            int line;
+            BenchFunc func;
+            Benchmark *next;
+        };
+
+        // Узлы лежат в статических Registrar, как и у тестов
+        inline guard::detail::IntrusiveList<Benchmark> &registry()
+        {
+            static guard::detail::IntrusiveList<Benchmark> instance;
+            return instance;
+        }
+
+        struct Registrar
+        {
+            Registrar(const char *name, const char *file, int line, BenchFunc func)
+                : node{name, file, line, func, nullptr}
+            {
+                registry().push_back(&node);
+            }
+
+            Registrar(const Registrar &) = delete;
+            Registrar &operator=(const Registrar &) = delete;
+
+            Benchmark node;
+        };
+
+        struct Config
+        {
+            // Минимальная длительность одного замера; под неё
+            // подбирается число итераций
+            double min_time_ms = 10;
+            // Прогрев перед замерами
+            double warmup_ms = 20;
+            // Число замеров (повторений)
+            unsigned repetitions = 10;
+        };
+
+        struct Result
+        {
+            std::uint64_t iterations = 0;
+            // ns/op каждого повторения
+            std::vector<double> samples;
+            double median_ns = 0;
+            double mad_ns = 0;
+            double min_ns = 0;
+            double items_per_second = 0;
+            double bytes_per_second = 0;
+            // Аппаратные счётчики, суммарно за все повторения
+            // (iterations * samples.size() операций)
+            perf::Counts perf;
+        };
+
+        inline double median(std::vector<double> values)
+        {
+            if (values.empty())
+                return 0;
+            const std::size_t mid = values.size() / 2;
+            std::nth_element(values.begin(), values.begin() + mid, values.end());
+            double m = values[mid];
+            if (values.size() % 2 == 0)
+                m = (m + *std::max_element(values.begin(), values.begin() + mid)) / 2;
+            return m;
+        }
+
+        // Медианное абсолютное отклонение
+        inline double mad(const std::vector<double> &values, double center)
+        {
+            std::vector<double> dev(values.size());
+            for (std::size_t i = 0; i < values.size(); ++i)
+                dev[i] = std::fabs(values[i] - center);
+            return median(std::move(dev));
+        }
+
+        // Один вызов тела с заданным числом итераций; возвращает ns всего
+        inline double run_batch(const Benchmark &bm, std::uint64_t iterations, State *out = nullptr)
+        {
+            State state(iterations);
+            bm.func(state);
+            // Проваленная проверка в теле повторялась бы в каждом замере —
+            // прерываем бенчмарк после первой же партии
+            if (guard_check_env_failed())
+                GUARD_CHECK_ENV_RAISE_IMPL();
+            if (!state.finished())
+                throw std::logic_error(
+                    "benchmark body must loop while state.keep_running() "
+                    "returns true");
+            if (out)
+                *out = state;
+            return state.elapsed_ns();
+        }
+
+        // Подбирает число итераций, при котором замер длится не меньше
+        // min_time_ms, прогревает и снимает repetitions замеров
+        inline Result measure(const Benchmark &bm, const Config &config)
+        {
+            const double target_ns = config.min_time_ms * 1e6;
+
+            std::uint64_t iterations = 1;
+            for (;;)
+            {
+                const double ns = run_batch(bm, iterations);
+                if (ns >= target_ns || iterations >= (std::uint64_t(1) << 40))
+                    break;
+                // Растим с запасом, но не больше чем в 10 раз за шаг
+                double scale = ns > 0 ? 1.4 * target_ns / ns : 10.0;
+                scale = std::min(10.0, std::max(2.0, scale));
+                iterations = static_cast<std::uint64_t>(std::ceil(iterations * scale));
+            }
+
+            const auto warmup_end =
+                Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double, std::milli>(config.warmup_ms));
+            while (Clock::now() < warmup_end)
+                run_batch(bm, iterations);
+
+            Result result;
+            result.iterations = iterations;
+            State last(0);
+            const unsigned repetitions = std::max(1u, config.repetitions);
+            for (unsigned r = 0; r < repetitions; ++r)
+            {
+                result.samples.push_back(run_batch(bm, iterations, &last) /
+                                         static_cast<double>(iterations));
+                result.perf += last.perf_counts();
+            }
+
+            result.median_ns = median(result.samples);
+            result.mad_ns = mad(result.samples, result.median_ns);
+            result.min_ns = *std::min_element(result.samples.begin(), result.samples.end());
+            if (result.median_ns > 0)
+            {
+                result.items_per_second = last.items_per_iteration() * 1e9 / result.median_ns;
+                result.bytes_per_second = last.bytes_per_iteration() * 1e9 / result.median_ns;
+            }
+            return result;
+        }
+
+        // 1234567 -> "1.23M"
+        inline std::string format_si(double value)
+        {
+            static const char *const suffixes[] = {"", "k", "M", "G", "T"};
+            std::size_t s = 0;
+            while (std::fabs(value) >= 1000 && s + 1 < sizeof(suffixes) / sizeof(*suffixes))
+            {
+                value /= 1000;
+                ++s;
+            }
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3g%s", value, suffixes[s]);
+            return buf;
+        }
+
+        // 0.123 -> "+12.3%"
+        inline std::string format_change(double change)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%+.1f%%", change * 100);
+            return buf;
+        }
+
+        inline std::string format_ns(double ns)
+        {
+            char buf[32];
+            if (ns < 1e3)
+                std::snprintf(buf, sizeof(buf), "%.3g ns", ns);
+            else if (ns < 1e6)
+                std::snprintf(buf, sizeof(buf), "%.3g us", ns / 1e3);
+            else if (ns < 1e9)
+                std::snprintf(buf, sizeof(buf), "%.3g ms", ns / 1e6);
+            else
+                std::snprintf(buf, sizeof(buf), "%.3g s", ns / 1e9);
+            return buf;
+        }
+
+        // ---------- сохранение замеров и сравнение с эталоном ----------
+
+        // Односторонний критерий Манна–Уитни: p-value гипотезы "current
+        // стохастически больше baseline" (т.е. стало медленнее). Нормальное
+        // приближение с поправкой на связки и на непрерывность.
+        inline double mann_whitney_greater_p(const std::vector<double> &baseline,
+                                             const std::vector<double> &current)
+        {
+            const double n1 = static_cast<double>(current.size());
+            const double n2 = static_cast<double>(baseline.size());
+            if (current.empty() || baseline.empty())
+                return 1.0;
+
+            // (значение, из current ли)
+            std::vector<std::pair<double, bool>> all;
+            all.reserve(current.size() + baseline.size());
+            for (double v : current)
+                all.push_back(std::make_pair(v, true));
+            for (double v : baseline)
+                all.push_back(std::make_pair(v, false));
+            std::sort(all.begin(), all.end());
+
+            double rank_sum = 0;
+            double tie_term = 0;
+            for (std::size_t i = 0; i < all.size();)
+            {
+                std::size_t j = i;
+                while (j < all.size() && all[j].first == all[i].first)
+                    ++j;
+                // Средний ранг группы одинаковых значений (ранги с 1)
+                const double rank = (i + 1 + j) / 2.0;
+                const double t = static_cast<double>(j - i);
+                tie_term += t * t * t - t;
+                for (std::size_t k = i; k < j; ++k)
+                    if (all[k].second)
+                        rank_sum += rank;
+                i = j;
+            }
+
+            const double n = n1 + n2;
+            const double u = rank_sum - n1 * (n1 + 1) / 2;
+            const double mean = n1 * n2 / 2;
+            const double var = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+            if (var <= 0)
+                return 1.0;
+            const double z = (u - mean - 0.5) / std::sqrt(var);
+            return 0.5 * std::erfc(z / std::sqrt(2.0));
+        }
+
+        struct CompareConfig
+        {
+            // Уровень значимости
+            double alpha = 0.01;
+            // Минимальное относительное замедление медианы, которое
+            // считается регрессией (0.05 = 5%)
+            double min_effect = 0.05;
+        };
+
+        struct Comparison
+        {
+            double old_median_ns = 0;
+            double new_median_ns = 0;
+            // Относительное изменение медианы (0.1 = на 10% медленнее)
+            double change = 0;
+            double p_value = 1;
+            bool regression = false;
+        };
+
+        inline Comparison compare(const std::vector<double> &baseline,
+                                  const Result &current,
+                                  const CompareConfig &config)
+        {
+            Comparison c;
+            c.old_median_ns = median(baseline);
+            c.new_median_ns = current.median_ns;
+            if (c.old_median_ns > 0)
+                c.change = c.new_median_ns / c.old_median_ns - 1;
+            c.p_value = mann_whitney_greater_p(baseline, current.samples);
+            c.regression = c.p_value < config.alpha && c.change > config.min_effect;
+            return c;
+        }
+
+        // ---------- относительная скорость двух участков кода ----------
+
+        struct SpeedConfig
+        {
+            // Длительность одной партии вызовов; под неё подбирается
+            // число итераций каждого участка
+            double batch_ms = 1;
+            // Доверительная вероятность интервала для отношения
+            double confidence = 0.95;
+            // Пар замеров в первом раунде; пока интервал накрывает
+            // порог, число пар удваивается до max_pairs
+            unsigned min_pairs = 15;
+            unsigned max_pairs = 255;
+            // Бюджет времени на удвоения
+            double max_time_ms = 3000;
+        };
+
+        struct SpeedRatio
+        {
+            // Медиана отношений slow/fast по парам замеров и
+            // непараметрический доверительный интервал для неё
+            double ratio = 0;
+            double lower = 0;
+            double upper = 0;
+            double confidence = 0;
+            unsigned pairs = 0;
+            // Медианы ns/op участков
+            double fast_ns = 0;
+            double slow_ns = 0;
+        };
+
+        namespace detail
+        {
+            template <typename F>
+            double time_calls(F &f, std::uint64_t iterations)
+            {
+                const auto start = Clock::now();
+                for (std::uint64_t i = 0; i < iterations; ++i)
+                {
+                    f();
+                    guard::clobber_memory();
+                }
+                return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            }
+
+            // Число итераций, при котором партия длится не меньше target_ns
+            template <typename F>
+            std::uint64_t calibrate(F &f, double target_ns)
+            {
+                std::uint64_t iterations = 1;
+                for (;;)
+                {
+                    const double ns = time_calls(f, iterations);
+                    if (ns >= target_ns || iterations >= (std::uint64_t(1) << 40))
+                        return iterations;
+                    double scale = ns > 0 ? 1.4 * target_ns / ns : 10.0;
+                    scale = std::min(10.0, std::max(2.0, scale));
+                    iterations = static_cast<std::uint64_t>(std::ceil(iterations * scale));
+                }
+            }
+
+            // Номер k (с нуля) порядковой статистики, для которого
+            // [x_k, x_{n-1-k}] накрывает медиану с вероятностью не ниже
+            // confidence: интервал промахивается с вероятностью
+            // 2 * P(Bin(n, 1/2) <= k), берётся наибольшее k, при котором
+            // она не больше 1 - confidence. Если не годится и k = 0
+            // (слишком мало замеров), возвращается 0 — самый широкий интервал
+            inline std::size_t median_ci_rank(std::size_t n, double confidence)
+            {
+                const double tail = (1 - confidence) / 2;
+                double pmf = std::ldexp(1.0, -static_cast<int>(n));
+                double cdf = 0;
+                // Первое k с P(Bin <= k) > tail (или n / 2)
+                std::size_t k = 0;
+                while (k < n / 2)
+                {
+                    cdf += pmf;
+                    if (cdf > tail)
+                        break;
+                    pmf = pmf * static_cast<double>(n - k) / static_cast<double>(k + 1);
+                    ++k;
+                }
+                return k > 0 ? k - 1 : 0;
+            }
+        } // namespace detail
+
+        // Сравнивает скорость двух участков: партии вызовов чередуются
+        // (fast, slow, затем slow, fast), чтобы дрейф частоты и кэшей
+        // влиял на оба одинаково, для каждой пары считается отношение
+        // ns/op slow к fast. Интервал для медианы отношений строится по
+        // порядковым статистикам и не предполагает нормальности. Пока он
+        // накрывает min_ratio, замеры продолжаются (до max_pairs и бюджета).
+        template <typename Fast, typename Slow>
+        SpeedRatio compare_speed(Fast &&fast, Slow &&slow, double min_ratio,
+                                 const SpeedConfig &config = SpeedConfig())
+        {
+            const auto deadline =
+                Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double, std::milli>(config.max_time_ms));
+            const double target_ns = config.batch_ms * 1e6;
+            const std::uint64_t fast_iterations = detail::calibrate(fast, target_ns);
+            const std::uint64_t slow_iterations = detail::calibrate(slow, target_ns);
+
+            std::vector<double> ratios;
+            std::vector<double> fast_ns;
+            std::vector<double> slow_ns;
+            SpeedRatio result;
+            result.confidence = config.confidence;
+            std::size_t wanted = std::max(1u, config.min_pairs);
+            for (;;)
+            {
+                while (ratios.size() < wanted)
+                {
+                    double f = 0;
+                    double sl = 0;
+                    if (ratios.size() % 2 == 0)
+                    {
+                        f = detail::time_calls(fast, fast_iterations);
+                        sl = detail::time_calls(slow, slow_iterations);
+                    }
+                    else
+                    {
+                        sl = detail::time_calls(slow, slow_iterations);
+                        f = detail::time_calls(fast, fast_iterations);
+                    }
+                    f /= static_cast<double>(fast_iterations);
+                    sl /= static_cast<double>(slow_iterations);
+                    fast_ns.push_back(f);
+                    slow_ns.push_back(sl);
+                    ratios.push_back(f > 0 ? sl / f : 0);
+                }
+
+                std::vector<double> sorted = ratios;
+                std::sort(sorted.begin(), sorted.end());
+                const std::size_t k = detail::median_ci_rank(sorted.size(), config.confidence);
+                result.ratio = median(ratios);
+                result.lower = sorted[k];
+                result.upper = sorted[sorted.size() - 1 - k];
+                result.pairs = static_cast<unsigned>(sorted.size());
+
+                const bool decided = result.lower >= min_ratio || result.upper < min_ratio;
+                if (decided || wanted >= config.max_pairs || Clock::now() >= deadline)
+                    break;
+                wanted = std::min<std::size_t>(wanted * 2 + 1, config.max_pairs);
+            }
+            result.fast_ns = median(std::move(fast_ns));
+            result.slow_ns = median(std::move(slow_ns));
+            return result;
+        }
+
+        // "1.53x (95% CI 1.48x..1.60x, 31 pairs, 12.3 ns vs 18.9 ns)"
+        inline std::string describe(const SpeedRatio &r)
+        {
+            char buf[96];
+            std::snprintf(buf,
+                          sizeof(buf),
+                          "%.3gx (%g%% CI %.3gx..%.3gx, %u pairs, ",
+                          r.ratio,
+                          r.confidence * 100,
+                          r.lower,
+                          r.upper,
+                          r.pairs);
+            return buf + format_ns(r.fast_ns) + " vs " + format_ns(r.slow_ns) + ")";
+        }
+
+        // ---------- эмпирическая сложность ----------
+
+        // Классы сложности в порядке роста
+        enum class Complexity
+        {
+            o1,
+            oLogN,
+            oN,
+            oNLogN,
+            oN2,
+            oN3
+        };
+
+        inline const char *complexity_name(Complexity c)
+        {
+            switch (c)
+            {
+            case Complexity::o1:
+                return "O(1)";
+            case Complexity::oLogN:
+                return "O(log n)";
+            case Complexity::oN:
+                return "O(n)";
+            case Complexity::oNLogN:
+                return "O(n log n)";
+            case Complexity::oN2:
+                return "O(n^2)";
+            case Complexity::oN3:
+                return "O(n^3)";
+            }
+            return "O(?)";
+        }
+
+        // Значение функции класса в точке n
+        inline double complexity_value(Complexity c, double n)
+        {
+            switch (c)
+            {
+            case Complexity::o1:
+                return 1;
+            case Complexity::oLogN:
+                return std::log2(n);
+            case Complexity::oN:
+                return n;
+            case Complexity::oNLogN:
+                return n * std::log2(n);
+            case Complexity::oN2:
+                return n * n;
+            case Complexity::oN3:
+                return n * n * n;
+            }
+            return 1;
+        }
+
+        struct ComplexityConfig
+        {
+            // Размеры: min_n, min_n * growth, ... (не больше max_n)
+            std::size_t min_n = 64;
+            std::size_t max_n = 65536;
+            double growth = 2;
+            // Минимальная длительность одного замера в точке
+            double min_time_ms = 2;
+            // Замеров в точке; берётся медиана
+            unsigned repetitions = 5;
+            // Допуск на шум: выбирается простейший класс, чья ошибка
+            // аппроксимации не больше best * (1 + rel) + abs
+            double tolerance_rel = 0.25;
+            double tolerance_abs = 0.02;
+        };
+
+        struct ComplexityPoint
+        {
+            std::size_t n;
+            // Медиана ns на один вызов
+            double ns;
+        };
+
+        // Аппроксимация t(n) = a + c * f(n), a >= 0, c >= 0
+        struct ComplexityFit
+        {
+            Complexity complexity;
+            double a;
+            double c;
+            // Среднеквадратичная относительная ошибка по точкам
+            double rms;
+
+            double predict(std::size_t n) const
+            {
+                return a + c * complexity_value(complexity, static_cast<double>(n));
+            }
+        };
+
+        struct ComplexityResult
+        {
+            std::vector<ComplexityPoint> points;
+            // Все классы в порядке роста
+            std::vector<ComplexityFit> fits;
+            // Выбранный класс (индекс в fits)
+            std::size_t best = 0;
+
+            const ComplexityFit &best_fit() const
+            {
+                return fits[best];
+            }
+        };
+
+        namespace detail
+        {
+            // Взвешенный МНК с весами 1/t^2, то есть по относительным
+            // отклонениям: точки с малым n весят столько же, сколько с
+            // большим. Свободный член поглощает постоянные накладные
+            // расходы, которые иначе выдают O(n) за O(log n)
+            inline ComplexityFit fit_complexity(const std::vector<ComplexityPoint> &points,
+                                                Complexity complexity)
+            {
+                double s = 0, sf = 0, st = 0, sff = 0, sft = 0;
+                for (const ComplexityPoint &p : points)
+                {
+                    const double t = std::max(p.ns, 1e-3);
+                    const double w = 1 / (t * t);
+                    const double f = complexity_value(complexity, static_cast<double>(p.n));
+                    s += w;
+                    sf += w * f;
+                    st += w * t;
+                    sff += w * f * f;
+                    sft += w * f * t;
+                }
+                ComplexityFit fit = {complexity, st / s, 0, 0};
+                const double det = s * sff - sf * sf;
+                if (complexity != Complexity::o1 && det > 1e-12 * s * sff)
+                {
+                    const double c = (s * sft - sf * st) / det;
+                    const double a = (st - c * sf) / s;
+                    if (c > 0 && a >= 0)
+                    {
+                        fit.a = a;
+                        fit.c = c;
+                    }
+                    else if (c > 0 || sft > 0)
+                    {
+                        fit.a = 0;
+                        fit.c = sft / sff;
+                    }
+                }
+                double sum = 0;
+                for (const ComplexityPoint &p : points)
+                {
+                    const double t = std::max(p.ns, 1e-3);
+                    const double e = (t - fit.predict(p.n)) / t;
+                    sum += e * e;
+                }
+                fit.rms = points.empty() ? 0 : std::sqrt(sum / static_cast<double>(points.size()));
+                return fit;
+            }
+        } // namespace detail
+
+        // Аппроксимирует замеры всеми классами и выбирает простейший,
+        // который описывает их не хуже лучшего с учётом допуска на шум:
+        // у более сложного класса больше свободы, и на зашумлённых
+        // данных он всегда выигрывает на доли процента
+        inline ComplexityResult fit_complexity(std::vector<ComplexityPoint> points,
+                                               const ComplexityConfig &config = ComplexityConfig())
+        {
+            ComplexityResult result;
+            result.points = std::move(points);
+            double best_rms = 0;
+            for (int c = 0; c <= static_cast<int>(Complexity::oN3); ++c)
+            {
+                result.fits.push_back(
+                    detail::fit_complexity(result.points, static_cast<Complexity>(c)));
+                const double rms = result.fits.back().rms;
+                if (c == 0 || rms < best_rms)
+                    best_rms = rms;
+            }
+            const double limit = best_rms * (1 + config.tolerance_rel) + config.tolerance_abs;
+            while (result.fits[result.best].rms > limit)
+                ++result.best;
+            return result;
+        }
+
+        // Прогоняет body(n) по геометрической сетке размеров: в каждой
+        // точке подбирается число вызовов на замер и берётся медиана
+        // repetitions замеров
+        template <typename Body>
+        ComplexityResult measure_complexity(Body &&body,
+                                            const ComplexityConfig &config = ComplexityConfig())
+        {
+            const double target_ns = config.min_time_ms * 1e6;
+            const double growth = std::max(config.growth, 1.1);
+            std::vector<ComplexityPoint> points;
+            std::vector<double> samples;
+            for (double x = static_cast<double>(std::max<std::size_t>(config.min_n, 1));
+                 x <= static_cast<double>(config.max_n);
+                 x *= growth)
+            {
+                const std::size_t n = static_cast<std::size_t>(x);
+                if (!points.empty() && points.back().n == n)
+                    continue;
+                auto call = [&]() { body(n); };
+                const std::uint64_t iterations = detail::calibrate(call, target_ns);
+                samples.clear();
+                for (unsigned r = 0; r < std::max(1u, config.repetitions); ++r)
+                    samples.push_back(detail::time_calls(call, iterations) /
+                                      static_cast<double>(iterations));
+                points.push_back(ComplexityPoint{n, median(samples)});
+            }
+            return fit_complexity(std::move(points), config);
+        }
+
+        // "O(n^2) (rms 1.2%); O(1) 84%, O(log n) 70%, O(n) 22%, ..."
+        inline std::string describe(const ComplexityResult &r)
+        {
+            if (r.fits.empty())
+                return "no data";
+            char buf[64];
+            std::snprintf(buf,
+                          sizeof(buf),
+                          "%s (rms %.3g%%);",
+                          complexity_name(r.best_fit().complexity),
+                          r.best_fit().rms * 100);
+            std::string text = buf;
+            for (std::size_t i = 0; i < r.fits.size(); ++i)
+            {
+                std::snprintf(buf,
+                              sizeof(buf),
+                              "%s %s %.3g%%",
+                              i == 0 ? "" : ",",
+                              complexity_name(r.fits[i].complexity),
+                              r.fits[i].rms * 100);
+                text += buf;
+            }
+            text += "; " + std::to_string(r.points.size()) + " sizes " +
+                    std::to_string(r.points.empty() ? 0 : r.points.front().n) + ".." +
+                    std::to_string(r.points.empty() ? 0 : r.points.back().n);
+            return text;
+        }
+
+        // Файл CSV для замеров сложности (--complexity-csv); пустая
+        // строка — не сохранять
+        inline std::string &complexity_csv_path()
+        {
+            static std::string path;
+            return path;
+        }
+
+        // Создаёт файл с заголовком; false — файл не открылся
+        inline bool start_complexity_csv(const char *path)
+        {
+            std::FILE *f = std::fopen(path, "w");
+            if (!f)
+                return false;
+            std::fputs("file,line,check,n,ns,best_fit,fit_ns\n", f);
+            std::fclose(f);
+            complexity_csv_path() = path;
+            return true;
+        }
+
+        namespace detail
+        {
+            // Поле CSV в кавычках
+            inline void append_csv_field(std::string &out, const char *text)
+            {
+                out += '"';
+                for (const char *c = text ? text : ""; *c; ++c)
+                {
+                    if (*c == '"')
+                        out += '"';
+                    out += *c;
+                }
+                out += '"';
+            }
+        } // namespace detail
+
+        // Дописывает точки одной проверки одним небуферизованным fwrite в
+        // режиме дозаписи: строки рабочих процессов не перемешиваются
+        inline void append_complexity_csv(const char *file, int line, const char *check,
+                                          const ComplexityResult &r)
+        {
+            const std::string &path = complexity_csv_path();
+            if (path.empty() || r.fits.empty())
+                return;
+            std::string prefix;
+            detail::append_csv_field(prefix, file);
+            prefix += ',' + std::to_string(line) + ',';
+            detail::append_csv_field(prefix, check);
+            const char *fit_name = complexity_name(r.best_fit().complexity);
+            std::string text;
+            char buf[96];
+            for (const ComplexityPoint &p : r.points)
+            {
+                std::snprintf(buf,
+                              sizeof(buf),
+                              ",%llu,%.6g,%s,%.6g\n",
+                              static_cast<unsigned long long>(p.n),
+                              p.ns,
+                              fit_name,
+                              r.best_fit().predict(p.n));
+                text += prefix;
+                text += buf;
+            }
+            std::FILE *f = std::fopen(path.c_str(), "a");
+            if (!f)
+                return;
+            std::setvbuf(f, nullptr, _IONBF, 0);
+            std::fwrite(text.data(), 1, text.size(), f);
+            std::fclose(f);
+        }
+
+        namespace detail
+        {
+            // Длина корректной последовательности UTF-8 в начале s (доступно
+            // left байт) или 0: обрывки, лишние байты продолжения, избыточные
+            // формы, суррогаты и коды выше U+10FFFF некорректны
+            inline std::size_t utf8_length(const char *s, std::size_t left)
+            {
+                const unsigned char *p = reinterpret_cast<const unsigned char *>(s);
+                if (p[0] < 0x80)
+                    return 1;
+                std::size_t n = 0;
+                unsigned char low = 0x80;
+                unsigned char high = 0xbf;
+                if (p[0] >= 0xc2 && p[0] <= 0xdf)
+                    n = 2;
+                else if (p[0] >= 0xe0 && p[0] <= 0xef)
+                {
+                    n = 3;
+                    if (p[0] == 0xe0)
+                        low = 0xa0;
+                    else if (p[0] == 0xed)
+                        high = 0x9f;
+                }
+                else if (p[0] >= 0xf0 && p[0] <= 0xf4)
+                {
+                    n = 4;
+                    if (p[0] == 0xf0)
+                        low = 0x90;
+                    else if (p[0] == 0xf4)
+                        high = 0x8f;
+                }
+                else
+                    return 0;
+                if (left < n || p[1] < low || p[1] > high)
+                    return 0;
+                for (std::size_t i = 2; i < n; ++i)
+                    if ((p[i] & 0xc0) != 0x80)
+                        return 0;
+                return n;
+            }
+
+            // U+FFFD в UTF-8: замена байта, не образующего символ
+            const char utf8_replacement[] = "\xef\xbf\xbd";
+
+            // Строка JSON из size байт: NUL внутри (вывод теста, текст
+            // исключения) не обрывает её, а уходит как \u0000; байты вне
+            // корректного UTF-8 заменяются на U+FFFD
+            inline void write_json_string(std::ostream &os, const char *s, std::size_t size)
+            {
+                os << '"';
+                for (std::size_t i = 0; i < size;)
+                {
+                    const unsigned char ch = static_cast<unsigned char>(s[i]);
+                    if (ch >= 0x80)
+                    {
+                        const std::size_t n = utf8_length(s + i, size - i);
+                        if (n == 0)
+                        {
+                            os << utf8_replacement;
+                            ++i;
+                        }
+                        else
+                        {
+                            os.write(s + i, static_cast<std::streamsize>(n));
+                            i += n;
+                        }
+                        continue;
+                    }
+                    if (ch == '"' || ch == '\\')
+                        os << '\\' << s[i];
+                    else if (ch == '\n')
+                        os << "\\n";
+                    else if (ch == '\t')
+                        os << "\\t";
+                    else if (ch < 0x20)
+                    {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                        os << buf;
+                    }
+                    else
+                        os << s[i];
+                    ++i;
+                }
+                os << '"';
+            }
+
+            inline void write_json_string(std::ostream &os, const char *s)
+            {
+                write_json_string(os, s, std::strlen(s));
+            }
+
+            inline void write_json_string(std::ostream &os, const std::string &s)
+            {
+                write_json_string(os, s.data(), s.size());
+            }
+
+            // Минимальный разборщик JSON ровно для файлов, которые пишет
+            // save_results: объекты, массивы, строки, числа, литералы
+            class JsonReader
+            {
+            public:
+                explicit JsonReader(const std::string &text) : m_text(text)
+                {
+                }
+
+                bool consume(char ch)
+                {
+                    skip_ws();
+                    if (m_pos < m_text.size() && m_text[m_pos] == ch)
+                    {
+                        ++m_pos;
+                        return true;
+                    }
+                    return false;
+                }
+
+                bool peek(char ch)
+                {
+                    skip_ws();
+                    return m_pos < m_text.size() && m_text[m_pos] == ch;
+                }
+
+                bool read_string(std::string &out)
+                {
+                    if (!consume('"'))
+                        return false;
+                    out.clear();
+                    while (m_pos < m_text.size() && m_text[m_pos] != '"')
+                    {
+                        char ch = m_text[m_pos++];
+                        if (ch == '\\' && m_pos < m_text.size())
+                        {
+                            ch = m_text[m_pos++];
+                            if (ch == 'n')
+                                ch = '\n';
+                            else if (ch == 't')
+                                ch = '\t';
+                            else if (ch == 'u' && m_pos + 4 <= m_text.size())
+                            {
+                                ch = static_cast<char>(
+                                    std::strtol(m_text.substr(m_pos, 4).c_str(), nullptr, 16));
+                                m_pos += 4;
+                            }
+                        }
+                        out += ch;
+                    }
+                    return consume('"');
+                }
+
+                bool read_number(double &out)
+                {
+                    skip_ws();
+                    const char *begin = m_text.c_str() + m_pos;
+                    char *end = nullptr;
+                    out = std::strtod(begin, &end);
+                    if (end == begin)
+                        return false;
+                    m_pos += static_cast<std::size_t>(end - begin);
+                    return true;
+                }
+
+                bool skip_value()
+                {
+                    std::string s;
+                    double d;
+                    if (peek('"'))
+                        return read_string(s);
+                    if (consume('['))
+                    {
+                        if (consume(']'))
+                            return true;
+                        do
+                        {
+                            if (!skip_value())
+                                return false;
+                        } while (consume(','));
+                        return consume(']');
+                    }
+                    if (consume('{'))
+                    {
+                        if (consume('}'))
+                            return true;
+                        do
+                        {
+                            if (!read_string(s) || !consume(':') || !skip_value())
+                                return false;
+                        } while (consume(','));
+                        return consume('}');
+                    }
+                    if (read_number(d))
+                        return true;
+                    // true / false / null
+                    while (m_pos < m_text.size() && std::isalpha(static_cast<unsigned char>(m_text[m_pos])))
+                        ++m_pos;
+                    return true;
+                }
+
+            private:
+                void skip_ws()
+                {
+                    while (m_pos < m_text.size() &&
+                           std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+                        ++m_pos;
+                }
+
+                const std::string &m_text;
+                std::size_t m_pos = 0;
+            };
+        } // namespace detail
+
+        // Сохраняет распределения замеров в JSON:
+        // {"format": "guard-benchmarks-1", "benchmarks": [{"name": ...,
+        //  "file": ..., "line": ..., "iterations": ..., "median_ns": ...,
+        //  "samples_ns": [...]}, ...]}
+        inline bool save_results(const char *path,
+                                 const std::vector<std::pair<const Benchmark *, Result>> &results)
+        {
+            std::ofstream out(path, std::ios::trunc);
+            if (!out)
+                return false;
+            out.precision(10);
+            out << "{\n  \"format\": \"guard-benchmarks-1\",\n  \"benchmarks\": [";
+            for (std::size_t i = 0; i < results.size(); ++i)
+            {
+                const Benchmark &bm = *results[i].first;
+                const Result &r = results[i].second;
+                out << (i ? ",\n" : "\n") << "    {\"name\": ";
+                detail::write_json_string(out, bm.name);
+                out << ", \"file\": ";
+                detail::write_json_string(out, bm.file);
+                out << ", \"line\": " << bm.line << ", \"iterations\": " << r.iterations
+                    << ", \"median_ns\": " << r.median_ns << ", \"samples_ns\": [";
+                for (std::size_t k = 0; k < r.samples.size(); ++k)
+                    out << (k ? ", " : "") << r.samples[k];
+                out << "]}";
+            }
+            out << "\n  ]\n}\n";
+            return static_cast<bool>(out.flush());
+        }
+
+        // Эталонные замеры, загруженные из файла save_results; ключ — имя
+        class Baseline
+        {
+        public:
+            bool load(const char *path)
+            {
+                std::ifstream in(path);
+                if (!in)
+                    return false;
+                std::stringstream buf;
+                buf << in.rdbuf();
+                const std::string text = buf.str();
+
+                detail::JsonReader json(text);
+                std::string key;
+                if (!json.consume('{'))
+                    return false;
+                if (json.consume('}'))
+                    return true;
+                do
+                {
+                    if (!json.read_string(key) || !json.consume(':'))
+                        return false;
+                    if (key != "benchmarks")
+                    {
+                        if (!json.skip_value())
+                            return false;
+                        continue;
+                    }
+                    if (!json.consume('['))
+                        return false;
+                    if (json.consume(']'))
+                        continue;
+                    do
+                    {
+                        if (!read_entry(json))
+                            return false;
+                    } while (json.consume(','));
+                    if (!json.consume(']'))
+                        return false;
+                } while (json.consume(','));
+                return json.consume('}');
+            }
+
+            const std::vector<double> *find(const char *name) const
+            {
+                auto it = m_samples.find(name);
+                return it == m_samples.end() ? nullptr : &it->second;
+            }
+
+        private:
+            bool read_entry(detail::JsonReader &json)
+            {
+                std::string key;
+                std::string name;
+                std::vector<double> samples;
+                if (!json.consume('{'))
+                    return false;
+                if (json.consume('}'))
+                    return true;
+                do
+                {
+                    if (!json.read_string(key) || !json.consume(':'))
+                        return false;
+                    if (key == "name")
+                    {
+                        if (!json.read_string(name))
+                            return false;
+                    }
+                    else if (key == "samples_ns")
+                    {
+                        double v = 0;
+                        if (!json.consume('['))
+                            return false;
+                        if (!json.consume(']'))
+                        {
+                            do
+                            {
+                                if (!json.read_number(v))
+                                    return false;
+                                samples.push_back(v);
+                            } while (json.consume(','));
+                            if (!json.consume(']'))
+                                return false;
+                        }
+                    }
+                    else if (!json.skip_value())
+                        return false;
+                } while (json.consume(','));
+                if (!name.empty())
+                    m_samples[name] = std::move(samples);
+                return json.consume('}');
+            }
+
+            std::map<std::string, std::vector<double>> m_samples;
+        };
+    } // namespace bench
+} // namespace guard
@@ -0,0 +1,627 @@
+// guard/bulk.h
+#pragma once
+
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+// Поэлементное сравнение больших массивов float/double: CHECK_ALL_APPROX
+// (допуск как у Approx) и CHECK_ALL_ULP (расстояние в единицах последнего
+// разряда).
+//
+// Массив проходится блоками. Векторный цикл только отвечает, есть ли в
+// блоке хоть одно несовпадение; такой блок пересматривается скалярным
+// кодом, который и собирает отчёт: число несовпадений, наибольшую ошибку
+// и первые индексы. Скалярная проверка — та же формула в той же
+// арифметике, поэтому результат не зависит от набора инструкций.
+//
+// Набор инструкций выбирается при компиляции (GUARD_TEST_SIMD):
+// 0 — скалярный код, 1 — SSE2, 2 — AVX, 3 — AVX2, 4 — NEON (AArch64).
+// -DGUARD_TEST_SIMD=0 отключает векторный цикл.
+
+#if !defined(GUARD_TEST_SIMD)
+#if defined(__AVX2__)
+#define GUARD_TEST_SIMD 3
+#elif defined(__AVX__)
+#define GUARD_TEST_SIMD 2
+#elif defined(__SSE2__) || defined(_M_X64)
+#define GUARD_TEST_SIMD 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define GUARD_TEST_SIMD 4
+#else
+#define GUARD_TEST_SIMD 0
+#endif
+#endif
+
+#if GUARD_TEST_SIMD >= 1 && GUARD_TEST_SIMD <= 3
+#include <immintrin.h>
+#elif GUARD_TEST_SIMD == 4
+#include <arm_neon.h>
+#endif
+
+namespace guard
+{
+    namespace bulk
+    {
+        inline const char *simd_name()
+        {
+            switch (GUARD_TEST_SIMD)
+            {
+            case 1:
+                return "SSE2";
+            case 2:
+                return "AVX";
+            case 3:
+                return "AVX2";
+            case 4:
+                return "NEON";
+            default:
+                return "scalar";
+            }
+        }
+
+        // Допуск как у Approx: |a - b| <= epsilon * (scale + |b|).
+        // Задаётся числом (epsilon, scale = 1) или готовым Approx
+        // (его значение не используется)
+        struct Tolerance
+        {
+            double epsilon;
+            double scale;
+
+            Tolerance(double eps) : epsilon(eps), scale(1.0)
+            {
+            }
+
+            Tolerance(const Approx &approx) : epsilon(approx.epsilon()), scale(approx.scale())
+            {
+            }
+        };
+
+        // Непрерывный массив без владения
+        template <typename T>
+        struct Span
+        {
+            const T *data;
+            std::size_t size;
+        };
+
+        template <typename T>
+        Span<T> span(const T *data, std::size_t size)
+        {
+            return Span<T>{data, size};
+        }
+
+        // Сколько первых несовпадений перечислять в сообщении
+        const std::size_t shown_mismatches = 8;
+
+        // Итог сравнения; ошибка — |a - b| или расстояние в ULP
+        struct Mismatches
+        {
+            std::size_t size_a = 0;
+            std::size_t size_b = 0;
+            std::size_t count = 0;
+            double max_error = 0;
+            std::size_t max_index = 0;
+            std::size_t first[shown_mismatches] = {};
+            std::size_t shown = 0;
+
+            bool ok() const
+            {
+                return size_a == size_b && count == 0;
+            }
+
+            void add(std::size_t index, double error)
+            {
+                if (count == 0 || !(error <= max_error))
+                {
+                    max_error = error;
+                    max_index = index;
+                }
+                if (shown < shown_mismatches)
+                    first[shown++] = index;
+                ++count;
+            }
+        };
+
+        namespace detail
+        {
+            // Элементов в блоке между проверками векторного цикла
+            const std::size_t block_size = 4096;
+
+            template <typename C>
+            auto as_span(const C &c) -> Span<typename std::remove_cv<
+                typename std::remove_reference<decltype(*c.data())>::type>::type>
+            {
+                typedef typename std::remove_cv<
+                    typename std::remove_reference<decltype(*c.data())>::type>::type T;
+                return Span<T>{c.data(), static_cast<std::size_t>(c.size())};
+            }
+
+            template <typename T, std::size_t N>
+            Span<T> as_span(const T (&array)[N])
+            {
+                return Span<T>{array, N};
+            }
+
+            template <typename T>
+            Span<T> as_span(const Span<T> &s)
+            {
+                return s;
+            }
+
+            // ----- скалярные формулы (образец для векторных) -----
+
+            template <typename T>
+            bool approx_ok(T a, T b, T eps, T scale)
+            {
+                return std::fabs(a - b) <= eps * (scale + std::fabs(b));
+            }
+
+            // Биты числа как целое, монотонное по значению: -x -> -bits(x),
+            // так что +0 и -0 совпадают, а соседние числа отличаются на 1
+            inline std::uint64_t ordered(double x)
+            {
+                std::uint64_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                const std::uint64_t sign = (bits >> 63) ? ~std::uint64_t(0) : 0;
+                return ((bits & 0x7FFFFFFFFFFFFFFFull) ^ sign) - sign;
+            }
+
+            inline std::uint32_t ordered(float x)
+            {
+                std::uint32_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                const std::uint32_t sign = (bits >> 31) ? ~std::uint32_t(0) : 0;
+                return ((bits & 0x7FFFFFFFu) ^ sign) - sign;
+            }
+
+            // Предел max_ulps: при нём проверка через один перенос
+            // (oa - ob + max <= 2 max без знака) не ошибается даже для
+            // бесконечностей разного знака
+            template <typename T>
+            struct UlpTraits;
+
+            template <>
+            struct UlpTraits<double>
+            {
+                typedef std::uint64_t Bits;
+
+                static std::uint64_t max_ulps()
+                {
+                    return std::uint64_t(1) << 52;
+                }
+            };
+
+            template <>
+            struct UlpTraits<float>
+            {
+                typedef std::uint32_t Bits;
+
+                static std::uint64_t max_ulps()
+                {
+                    return std::uint64_t(1) << 22;
+                }
+            };
+
+            template <typename T>
+            bool ulp_ok(T a, T b, typename UlpTraits<T>::Bits max)
+            {
+                typedef typename UlpTraits<T>::Bits Bits;
+                if (a != a || b != b)
+                    return false;
+                const Bits t = static_cast<Bits>(ordered(a) - ordered(b) + max);
+                return t <= static_cast<Bits>(2 * max);
+            }
+
+            template <typename T>
+            double ulp_distance(T a, T b)
+            {
+                if (a != a || b != b)
+                    return std::numeric_limits<double>::quiet_NaN();
+                typedef typename UlpTraits<T>::Bits Bits;
+                const Bits oa = ordered(a);
+                const Bits ob = ordered(b);
+                const Bits top = Bits(1) << (sizeof(Bits) * 8 - 1);
+                // Сравнение со сдвигом на знаковый бит — сравнение со знаком
+                return static_cast<double>((oa ^ top) >= (ob ^ top) ? oa - ob : ob - oa);
+            }
+
+            // ----- векторные циклы: есть ли в [0, n) несовпадение -----
+
+            inline bool any_bad_approx(const double *a, const double *b, std::size_t n,
+                                       double eps, double scale)
+            {
+                std::size_t i = 0;
+#if GUARD_TEST_SIMD == 2 || GUARD_TEST_SIMD == 3
+                const __m256d abs_mask =
+                    _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFll));
+                const __m256d veps = _mm256_set1_pd(eps);
+                const __m256d vscale = _mm256_set1_pd(scale);
+                __m256d ok = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m256d va = _mm256_loadu_pd(a + i);
+                    const __m256d vb = _mm256_loadu_pd(b + i);
+                    const __m256d diff = _mm256_and_pd(_mm256_sub_pd(va, vb), abs_mask);
+                    const __m256d tol =
+                        _mm256_mul_pd(veps, _mm256_add_pd(vscale, _mm256_and_pd(vb, abs_mask)));
+                    ok = _mm256_and_pd(ok, _mm256_cmp_pd(diff, tol, _CMP_LE_OQ));
+                }
+                if (_mm256_movemask_pd(ok) != 0xF)
+                    return true;
+#elif GUARD_TEST_SIMD == 1
+                const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFll));
+                const __m128d veps = _mm_set1_pd(eps);
+                const __m128d vscale = _mm_set1_pd(scale);
+                __m128d ok = _mm_castsi128_pd(_mm_set1_epi64x(-1));
+                for (; i + 2 <= n; i += 2)
+                {
+                    const __m128d va = _mm_loadu_pd(a + i);
+                    const __m128d vb = _mm_loadu_pd(b + i);
+                    const __m128d diff = _mm_and_pd(_mm_sub_pd(va, vb), abs_mask);
+                    const __m128d tol =
+                        _mm_mul_pd(veps, _mm_add_pd(vscale, _mm_and_pd(vb, abs_mask)));
+                    ok = _mm_and_pd(ok, _mm_cmple_pd(diff, tol));
+                }
+                if (_mm_movemask_pd(ok) != 0x3)
+                    return true;
+#elif GUARD_TEST_SIMD == 4
+                const float64x2_t veps = vdupq_n_f64(eps);
+                const float64x2_t vscale = vdupq_n_f64(scale);
+                uint64x2_t ok = vdupq_n_u64(~std::uint64_t(0));
+                for (; i + 2 <= n; i += 2)
+                {
+                    const float64x2_t va = vld1q_f64(a + i);
+                    const float64x2_t vb = vld1q_f64(b + i);
+                    const float64x2_t tol = vmulq_f64(veps, vaddq_f64(vscale, vabsq_f64(vb)));
+                    ok = vandq_u64(ok, vcleq_f64(vabdq_f64(va, vb), tol));
+                }
+                if (vminvq_u32(vreinterpretq_u32_u64(ok)) == 0)
+                    return true;
+#endif
+                for (; i < n; ++i)
+                {
+                    if (!approx_ok(a[i], b[i], eps, scale))
+                        return true;
+                }
+                return false;
+            }
+
+            inline bool any_bad_approx(const float *a, const float *b, std::size_t n,
+                                       float eps, float scale)
+            {
+                std::size_t i = 0;
+#if GUARD_TEST_SIMD == 2 || GUARD_TEST_SIMD == 3
+                const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+                const __m256 veps = _mm256_set1_ps(eps);
+                const __m256 vscale = _mm256_set1_ps(scale);
+                __m256 ok = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (; i + 8 <= n; i += 8)
+                {
+                    const __m256 va = _mm256_loadu_ps(a + i);
+                    const __m256 vb = _mm256_loadu_ps(b + i);
+                    const __m256 diff = _mm256_and_ps(_mm256_sub_ps(va, vb), abs_mask);
+                    const __m256 tol =
+                        _mm256_mul_ps(veps, _mm256_add_ps(vscale, _mm256_and_ps(vb, abs_mask)));
+                    ok = _mm256_and_ps(ok, _mm256_cmp_ps(diff, tol, _CMP_LE_OQ));
+                }
+                if (_mm256_movemask_ps(ok) != 0xFF)
+                    return true;
+#elif GUARD_TEST_SIMD == 1
+                const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+                const __m128 veps = _mm_set1_ps(eps);
+                const __m128 vscale = _mm_set1_ps(scale);
+                __m128 ok = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m128 va = _mm_loadu_ps(a + i);
+                    const __m128 vb = _mm_loadu_ps(b + i);
+                    const __m128 diff = _mm_and_ps(_mm_sub_ps(va, vb), abs_mask);
+                    const __m128 tol =
+                        _mm_mul_ps(veps, _mm_add_ps(vscale, _mm_and_ps(vb, abs_mask)));
+                    ok = _mm_and_ps(ok, _mm_cmple_ps(diff, tol));
+                }
+                if (_mm_movemask_ps(ok) != 0xF)
+                    return true;
+#elif GUARD_TEST_SIMD == 4
+                const float32x4_t veps = vdupq_n_f32(eps);
+                const float32x4_t vscale = vdupq_n_f32(scale);
+                uint32x4_t ok = vdupq_n_u32(~std::uint32_t(0));
+                for (; i + 4 <= n; i += 4)
+                {
+                    const float32x4_t va = vld1q_f32(a + i);
+                    const float32x4_t vb = vld1q_f32(b + i);
+                    const float32x4_t tol = vmulq_f32(veps, vaddq_f32(vscale, vabsq_f32(vb)));
+                    ok = vandq_u32(ok, vcleq_f32(vabdq_f32(va, vb), tol));
+                }
+                if (vminvq_u32(ok) == 0)
+                    return true;
+#endif
+                for (; i < n; ++i)
+                {
+                    if (!approx_ok(a[i], b[i], eps, scale))
+                        return true;
+                }
+                return false;
+            }
+
+            // В векторных циклах ULP знаковые биты (oa - ob + max) и
+            // (2 max - (oa - ob + max)) равны нулю ровно тогда, когда
+            // |oa - ob| <= max; NaN добавляется отдельной маской
+            inline bool any_bad_ulp(const double *a, const double *b, std::size_t n,
+                                    std::uint64_t max)
+            {
+                std::size_t i = 0;
+#if GUARD_TEST_SIMD == 3
+                const __m256i mag_mask = _mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFll);
+                const __m256i vmax = _mm256_set1_epi64x(static_cast<long long>(max));
+                const __m256i vmax2 = _mm256_set1_epi64x(static_cast<long long>(2 * max));
+                __m256d bad = _mm256_setzero_pd();
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m256d va = _mm256_loadu_pd(a + i);
+                    const __m256d vb = _mm256_loadu_pd(b + i);
+                    const __m256i ia = _mm256_castpd_si256(va);
+                    const __m256i ib = _mm256_castpd_si256(vb);
+                    const __m256i sa = _mm256_shuffle_epi32(_mm256_srai_epi32(ia, 31), 0xF5);
+                    const __m256i sb = _mm256_shuffle_epi32(_mm256_srai_epi32(ib, 31), 0xF5);
+                    const __m256i oa =
+                        _mm256_sub_epi64(_mm256_xor_si256(_mm256_and_si256(ia, mag_mask), sa), sa);
+                    const __m256i ob =
+                        _mm256_sub_epi64(_mm256_xor_si256(_mm256_and_si256(ib, mag_mask), sb), sb);
+                    const __m256i t = _mm256_add_epi64(_mm256_sub_epi64(oa, ob), vmax);
+                    const __m256i out = _mm256_or_si256(t, _mm256_sub_epi64(vmax2, t));
+                    bad = _mm256_or_pd(bad, _mm256_castsi256_pd(out));
+                    bad = _mm256_or_pd(bad, _mm256_cmp_pd(va, vb, _CMP_UNORD_Q));
+                }
+                if (_mm256_movemask_pd(bad) != 0)
+                    return true;
+#elif GUARD_TEST_SIMD == 1 || GUARD_TEST_SIMD == 2
+                const __m128i mag_mask = _mm_set1_epi64x(0x7FFFFFFFFFFFFFFFll);
+                const __m128i vmax = _mm_set1_epi64x(static_cast<long long>(max));
+                const __m128i vmax2 = _mm_set1_epi64x(static_cast<long long>(2 * max));
+                __m128d bad = _mm_setzero_pd();
+                for (; i + 2 <= n; i += 2)
+                {
+                    const __m128d va = _mm_loadu_pd(a + i);
+                    const __m128d vb = _mm_loadu_pd(b + i);
+                    const __m128i ia = _mm_castpd_si128(va);
+                    const __m128i ib = _mm_castpd_si128(vb);
+                    const __m128i sa = _mm_shuffle_epi32(_mm_srai_epi32(ia, 31), 0xF5);
+                    const __m128i sb = _mm_shuffle_epi32(_mm_srai_epi32(ib, 31), 0xF5);
+                    const __m128i oa = _mm_sub_epi64(_mm_xor_si128(_mm_and_si128(ia, mag_mask), sa), sa);
+                    const __m128i ob = _mm_sub_epi64(_mm_xor_si128(_mm_and_si128(ib, mag_mask), sb), sb);
+                    const __m128i t = _mm_add_epi64(_mm_sub_epi64(oa, ob), vmax);
+                    const __m128i out = _mm_or_si128(t, _mm_sub_epi64(vmax2, t));
+                    bad = _mm_or_pd(bad, _mm_castsi128_pd(out));
+                    bad = _mm_or_pd(bad, _mm_cmpunord_pd(va, vb));
+                }
+                if (_mm_movemask_pd(bad) != 0)
+                    return true;
+#elif GUARD_TEST_SIMD == 4
+                const int64x2_t mag_mask = vdupq_n_s64(0x7FFFFFFFFFFFFFFFll);
+                const int64x2_t vmax = vdupq_n_s64(static_cast<std::int64_t>(max));
+                const uint64x2_t vmax2 = vdupq_n_u64(2 * max);
+                uint64x2_t ok = vdupq_n_u64(~std::uint64_t(0));
+                for (; i + 2 <= n; i += 2)
+                {
+                    const float64x2_t va = vld1q_f64(a + i);
+                    const float64x2_t vb = vld1q_f64(b + i);
+                    const int64x2_t ia = vreinterpretq_s64_f64(va);
+                    const int64x2_t ib = vreinterpretq_s64_f64(vb);
+                    const int64x2_t sa = vshrq_n_s64(ia, 63);
+                    const int64x2_t sb = vshrq_n_s64(ib, 63);
+                    const int64x2_t oa = vsubq_s64(veorq_s64(vandq_s64(ia, mag_mask), sa), sa);
+                    const int64x2_t ob = vsubq_s64(veorq_s64(vandq_s64(ib, mag_mask), sb), sb);
+                    const int64x2_t t = vaddq_s64(vsubq_s64(oa, ob), vmax);
+                    ok = vandq_u64(ok, vcleq_u64(vreinterpretq_u64_s64(t), vmax2));
+                    ok = vandq_u64(ok, vandq_u64(vceqq_f64(va, va), vceqq_f64(vb, vb)));
+                }
+                if (vminvq_u32(vreinterpretq_u32_u64(ok)) == 0)
+                    return true;
+#endif
+                for (; i < n; ++i)
+                {
+                    if (!ulp_ok(a[i], b[i], max))
+                        return true;
+                }
+                return false;
+            }
+
+            inline bool any_bad_ulp(const float *a, const float *b, std::size_t n,
+                                    std::uint32_t max)
+            {
+                std::size_t i = 0;
+#if GUARD_TEST_SIMD == 3
+                const __m256i mag_mask = _mm256_set1_epi32(0x7FFFFFFF);
+                const __m256i vmax = _mm256_set1_epi32(static_cast<int>(max));
+                const __m256i vmax2 = _mm256_set1_epi32(static_cast<int>(2 * max));
+                __m256 bad = _mm256_setzero_ps();
+                for (; i + 8 <= n; i += 8)
+                {
+                    const __m256 va = _mm256_loadu_ps(a + i);
+                    const __m256 vb = _mm256_loadu_ps(b + i);
+                    const __m256i ia = _mm256_castps_si256(va);
+                    const __m256i ib = _mm256_castps_si256(vb);
+                    const __m256i sa = _mm256_srai_epi32(ia, 31);
+                    const __m256i sb = _mm256_srai_epi32(ib, 31);
+                    const __m256i oa =
+                        _mm256_sub_epi32(_mm256_xor_si256(_mm256_and_si256(ia, mag_mask), sa), sa);
+                    const __m256i ob =
+                        _mm256_sub_epi32(_mm256_xor_si256(_mm256_and_si256(ib, mag_mask), sb), sb);
+                    const __m256i t = _mm256_add_epi32(_mm256_sub_epi32(oa, ob), vmax);
+                    const __m256i out = _mm256_or_si256(t, _mm256_sub_epi32(vmax2, t));
+                    bad = _mm256_or_ps(bad, _mm256_castsi256_ps(out));
+                    bad = _mm256_or_ps(bad, _mm256_cmp_ps(va, vb, _CMP_UNORD_Q));
+                }
+                if (_mm256_movemask_ps(bad) != 0)
+                    return true;
+#elif GUARD_TEST_SIMD == 1 || GUARD_TEST_SIMD == 2
+                const __m128i mag_mask = _mm_set1_epi32(0x7FFFFFFF);
+                const __m128i vmax = _mm_set1_epi32(static_cast<int>(max));
+                const __m128i vmax2 = _mm_set1_epi32(static_cast<int>(2 * max));
+                __m128 bad = _mm_setzero_ps();
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m128 va = _mm_loadu_ps(a + i);
+                    const __m128 vb = _mm_loadu_ps(b + i);
+                    const __m128i ia = _mm_castps_si128(va);
+                    const __m128i ib = _mm_castps_si128(vb);
+                    const __m128i sa = _mm_srai_epi32(ia, 31);
+                    const __m128i sb = _mm_srai_epi32(ib, 31);
+                    const __m128i oa = _mm_sub_epi32(_mm_xor_si128(_mm_and_si128(ia, mag_mask), sa), sa);
+                    const __m128i ob = _mm_sub_epi32(_mm_xor_si128(_mm_and_si128(ib, mag_mask), sb), sb);
+                    const __m128i t = _mm_add_epi32(_mm_sub_epi32(oa, ob), vmax);
+                    const __m128i out = _mm_or_si128(t, _mm_sub_epi32(vmax2, t));
+                    bad = _mm_or_ps(bad, _mm_castsi128_ps(out));
+                    bad = _mm_or_ps(bad, _mm_cmpunord_ps(va, vb));
+                }
+                if (_mm_movemask_ps(bad) != 0)
+                    return true;
+#elif GUARD_TEST_SIMD == 4
+                const int32x4_t mag_mask = vdupq_n_s32(0x7FFFFFFF);
+                const int32x4_t vmax = vdupq_n_s32(static_cast<std::int32_t>(max));
+                const uint32x4_t vmax2 = vdupq_n_u32(2 * max);
+                uint32x4_t ok = vdupq_n_u32(~std::uint32_t(0));
+                for (; i + 4 <= n; i += 4)
+                {
+                    const float32x4_t va = vld1q_f32(a + i);
+                    const float32x4_t vb = vld1q_f32(b + i);
+                    const int32x4_t ia = vreinterpretq_s32_f32(va);
+                    const int32x4_t ib = vreinterpretq_s32_f32(vb);
+                    const int32x4_t sa = vshrq_n_s32(ia, 31);
+                    const int32x4_t sb = vshrq_n_s32(ib, 31);
+                    const int32x4_t oa = vsubq_s32(veorq_s32(vandq_s32(ia, mag_mask), sa), sa);
+                    const int32x4_t ob = vsubq_s32(veorq_s32(vandq_s32(ib, mag_mask), sb), sb);
+                    const int32x4_t t = vaddq_s32(vsubq_s32(oa, ob), vmax);
+                    ok = vandq_u32(ok, vcleq_u32(vreinterpretq_u32_s32(t), vmax2));
+                    ok = vandq_u32(ok, vandq_u32(vceqq_f32(va, va), vceqq_f32(vb, vb)));
+                }
+                if (vminvq_u32(ok) == 0)
+                    return true;
+#endif
+                for (; i < n; ++i)
+                {
+                    if (!ulp_ok(a[i], b[i], max))
+                        return true;
+                }
+                return false;
+            }
+
+            template <typename T>
+            void check_element_type()
+            {
+                static_assert(std::is_same<T, double>::value || std::is_same<T, float>::value,
+                              "CHECK_ALL_APPROX / CHECK_ALL_ULP compare float or double arrays");
+            }
+
+            template <typename T>
+            void print_number(std::ostream &os, T value)
+            {
+                os.precision(std::numeric_limits<T>::max_digits10);
+                os << value;
+            }
+        } // namespace detail
+
+        // |a[i] - b[i]| <= epsilon * (scale + |b[i]|) для всех i; b — эталон
+        template <typename T>
+        Mismatches approx_all(Span<T> a, Span<T> b, const Tolerance &tolerance)
+        {
+            detail::check_element_type<T>();
+            Mismatches result;
+            result.size_a = a.size;
+            result.size_b = b.size;
+            if (a.size != b.size)
+                return result;
+            const T eps = static_cast<T>(tolerance.epsilon);
+            const T scale = static_cast<T>(tolerance.scale);
+            for (std::size_t begin = 0; begin < a.size; begin += detail::block_size)
+            {
+                const std::size_t end = std::min(a.size, begin + detail::block_size);
+                if (!detail::any_bad_approx(a.data + begin, b.data + begin, end - begin, eps, scale))
+                    continue;
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    if (!detail::approx_ok(a.data[i], b.data[i], eps, scale))
+                        result.add(i, std::fabs(static_cast<double>(a.data[i]) - b.data[i]));
+                }
+            }
+            return result;
+        }
+
+        // a[i] и b[i] отстоят не больше чем на max_ulps представимых чисел;
+        // NaN не совпадает ни с чем. max_ulps ограничен 2^52 (double) и
+        // 2^22 (float)
+        template <typename T>
+        Mismatches ulp_all(Span<T> a, Span<T> b, std::uint64_t max_ulps)
+        {
+            detail::check_element_type<T>();
+            typedef typename detail::UlpTraits<T>::Bits Bits;
+            Mismatches result;
+            result.size_a = a.size;
+            result.size_b = b.size;
+            if (a.size != b.size)
+                return result;
+            const Bits max = static_cast<Bits>(
+                std::min(max_ulps, detail::UlpTraits<T>::max_ulps()));
+            for (std::size_t begin = 0; begin < a.size; begin += detail::block_size)
+            {
+                const std::size_t end = std::min(a.size, begin + detail::block_size);
+                if (!detail::any_bad_ulp(a.data + begin, b.data + begin, end - begin, max))
+                    continue;
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    if (!detail::ulp_ok(a.data[i], b.data[i], max))
+                        result.add(i, detail::ulp_distance(a.data[i], b.data[i]));
+                }
+            }
+            return result;
+        }
+
+        // "3 of 10000000 elements differ, max error 0.0012 at [42]
+        // (1.5 vs 1.5012); first: [42] 1.5 vs 1.5012, [77] ..."
+        template <typename T>
+        std::string describe(const Mismatches &m, Span<T> a, Span<T> b, const char *unit)
+        {
+            std::ostringstream os;
+            if (m.size_a != m.size_b)
+            {
+                os << "sizes differ: " << m.size_a << " vs " << m.size_b;
+                return os.str();
+            }
+            os << m.count << " of " << m.size_a << (m.size_a == 1 ? " element" : " elements")
+               << " differ, max error ";
+            os << m.max_error << unit << " at [" << m.max_index << "] (";
+            detail::print_number(os, a.data[m.max_index]);
+            os << " vs ";
+            detail::print_number(os, b.data[m.max_index]);
+            os << "); first:";
+            for (std::size_t k = 0; k < m.shown; ++k)
+            {
+                const std::size_t i = m.first[k];
+                os << (k == 0 ? " [" : ", [") << i << "] ";
+                detail::print_number(os, a.data[i]);
+                os << " vs ";
+                detail::print_number(os, b.data[i]);
+            }
+            if (m.count > m.shown)
+                os << ", ...";
+            return os.str();
+        }
+
+        inline std::string describe(const Tolerance &tolerance)
+        {
+            std::ostringstream os;
+            os << "|a - b| <= " << tolerance.epsilon << " * (" << tolerance.scale << " + |b|)";
+            return os.str();
+        }
+    } // namespace bulk
+} // namespace guard
@@ -0,0 +1,349 @@
+// guard/capture.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#if !defined(GUARD_TEST_FD_CAPTURE_SUPPORTED)
+#if defined(__unix__) || defined(__APPLE__)
+#define GUARD_TEST_FD_CAPTURE_SUPPORTED 1
+#else
+#define GUARD_TEST_FD_CAPTURE_SUPPORTED 0
+#endif
+#endif
+
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#endif
+
+namespace guard
+{
+    namespace detail
+    {
+        // Что перехватывать во время теста
+        enum class CaptureMode
+        {
+            // std::cout через диспетчер потоков раннера
+            Stream,
+            // Дескрипторы 1 и 2: printf, write(1, ...), std::cerr, C-библиотеки
+            Fd,
+            // Ничего: вывод теста идёт прямо в терминал
+            None
+        };
+
+        struct CaptureSettings
+        {
+            CaptureMode mode = CaptureMode::Stream;
+            // Сколько последних байт вывода хранить для проваленного
+            // теста; 0 — без ограничения
+            std::size_t limit = 64 * 1024;
+        };
+
+        // Задаётся раннером до запуска тестов
+        inline CaptureSettings &capture_settings()
+        {
+            static CaptureSettings settings;
+            return settings;
+        }
+
+        // Хвост вывода теста. Память выделяется один раз на поток и
+        // переиспользуется между тестами; при ограничении буфер кольцевой
+        // и хранит только последние limit байт
+        class TailBuffer
+        {
+        public:
+            // Вызывается до теста, чтобы рост буфера не попал в подсчёт
+            // выделений самого теста
+            void prepare(std::size_t limit)
+            {
+                m_limit = limit;
+                if (m_limit > 0 && m_data.size() != m_limit)
+                    m_data.assign(m_limit, '\0');
+                clear();
+            }
+
+            void clear()
+            {
+                m_pos = 0;
+                m_total = 0;
+            }
+
+            void append(const char *data, std::size_t size)
+            {
+                if (m_limit == 0)
+                {
+                    if (m_data.size() < m_total + size)
+                        m_data.resize(std::max(m_data.size() * 2, m_total + size));
+                    std::memcpy(&m_data[m_total], data, size);
+                    m_total += size;
+                    return;
+                }
+                m_total += size;
+                if (size >= m_limit)
+                {
+                    std::memcpy(&m_data[0], data + size - m_limit, m_limit);
+                    m_pos = 0;
+                    return;
+                }
+                const std::size_t first = std::min(size, m_limit - m_pos);
+                std::memcpy(&m_data[m_pos], data, first);
+                std::memcpy(&m_data[0], data + first, size - first);
+                m_pos = (m_pos + size) % m_limit;
+            }
+
+            // Учесть байты, которые были выведены, но не попали в буфер
+            // (только при ограничении и только перед append)
+            void skip(std::size_t size)
+            {
+                m_total += size;
+            }
+
+            std::size_t total() const
+            {
+                return m_total;
+            }
+
+            std::size_t limit() const
+            {
+                return m_limit;
+            }
+
+            // Текст для отчёта; отброшенное начало помечается строкой
+            std::string str() const
+            {
+                if (m_limit == 0 || m_total <= m_limit)
+                    return std::string(m_data.data(), m_total);
+                std::string result = "[... " + std::to_string(m_total - m_limit) +
+                                     " bytes dropped]\n";
+                result.reserve(result.size() + m_limit);
+                result.append(m_data.data() + m_pos, m_limit - m_pos);
+                result.append(m_data.data(), m_pos);
+                return result;
+            }
+
+        private:
+            std::vector<char> m_data;
+            std::size_t m_limit = 0;
+            std::size_t m_pos = 0;
+            std::size_t m_total = 0;
+        };
+
+        // std::cout потока теста, пишущий в TailBuffer. Запись идёт под
+        // блокировкой: сторож таймаутов снимает копию вывода зависшего
+        // теста из другого потока (snapshot)
+        class TailStreamBuf : public std::streambuf
+        {
+        public:
+            TailBuffer buffer;
+
+            std::string snapshot()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return buffer.str();
+            }
+
+        protected:
+            int_type overflow(int_type ch) override
+            {
+                if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                {
+                    const char c = traits_type::to_char_type(ch);
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    buffer.append(&c, 1);
+                }
+                return traits_type::not_eof(ch);
+            }
+
+            std::streamsize xsputn(const char *s, std::streamsize n) override
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                buffer.append(s, static_cast<std::size_t>(n));
+                return n;
+            }
+
+        private:
+            std::mutex m_mutex;
+        };
+
+        inline TailStreamBuf &thread_capture_buf()
+        {
+            static thread_local TailStreamBuf buf;
+            return buf;
+        }
+
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+        // Перехват дескрипторов 1 и 2 на время теста. Оба направляются в
+        // один безымянный файл в памяти (memfd в Linux, иначе удалённый
+        // временный файл): записи в оба дескриптора идут в порядке вызовов
+        // write, а отдельный поток для вычитывания канала не нужен. После теста
+        // файл обрезается до нуля: для прошедшего теста вывод не читается
+        // вовсе, для проваленного в память процесса копируется только
+        // хвост. Дескрипторы общие на процесс, так что перехват годится
+        // для последовательного прогона и рабочих --fork-workers.
+        class FdCapture
+        {
+        public:
+            ~FdCapture()
+            {
+                if (m_file >= 0)
+                    ::close(m_file);
+            }
+
+            // false — перехват не удался, тест идёт без него
+            bool begin()
+            {
+                if (m_owner != ::getpid())
+                    reopen();
+                if (m_file < 0)
+                    return false;
+
+                flush_all();
+                m_saved_out = ::dup(1);
+                m_saved_err = ::dup(2);
+                if (m_saved_out < 0 || m_saved_err < 0 || ::dup2(m_file, 1) < 0 ||
+                    ::dup2(m_file, 2) < 0)
+                {
+                    restore();
+                    return false;
+                }
+                return true;
+            }
+
+            // Возвращает дескрипторы; при keep дописывает хвост вывода в out
+            void end(TailBuffer &out, bool keep)
+            {
+                flush_all();
+                restore();
+                if (keep)
+                    read_tail(m_file, out);
+                truncate(m_file);
+            }
+
+            // Использовать готовый файл вместо своего. Так рабочий процесс
+            // пишет в файл, созданный родителем до fork: родитель прочитает
+            // вывод теста, даже если рабочего пришлось убить
+            void adopt(int file)
+            {
+                if (m_file >= 0 && m_file != file)
+                    ::close(m_file);
+                m_file = file;
+                m_owner = ::getpid();
+            }
+
+            // Новый безымянный файл в памяти; -1 при ошибке
+            static int create_file()
+            {
+                int file = -1;
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+                file = ::memfd_create("guard-capture", MFD_CLOEXEC);
+#endif
+                if (file < 0)
+                {
+                    std::FILE *tmp = std::tmpfile();
+                    if (!tmp)
+                        return -1;
+                    file = ::fcntl(::fileno(tmp), F_DUPFD_CLOEXEC, 3);
+                    std::fclose(tmp);
+                }
+                return file;
+            }
+
+            // Дописывает в out хвост файла (не больше out.limit() байт)
+            static void read_tail(int file, TailBuffer &out)
+            {
+                const off_t size = ::lseek(file, 0, SEEK_CUR);
+                if (size <= 0)
+                    return;
+                const std::size_t total = static_cast<std::size_t>(size);
+                std::size_t offset = 0;
+                if (out.limit() > 0 && total > out.limit())
+                {
+                    offset = total - out.limit();
+                    out.skip(offset);
+                }
+                char chunk[4096];
+                while (offset < total)
+                {
+                    const std::size_t want = std::min(sizeof(chunk), total - offset);
+                    const ssize_t got = ::pread(file, chunk, want, static_cast<off_t>(offset));
+                    if (got < 0 && errno == EINTR)
+                        continue;
+                    if (got <= 0)
+                        break;
+                    out.append(chunk, static_cast<std::size_t>(got));
+                    offset += static_cast<std::size_t>(got);
+                }
+            }
+
+            static void truncate(int file)
+            {
+                if (::lseek(file, 0, SEEK_CUR) == 0)
+                    return;
+                while (::ftruncate(file, 0) < 0 && errno == EINTR)
+                {
+                }
+                ::lseek(file, 0, SEEK_SET);
+            }
+
+        private:
+            static void flush_all()
+            {
+                std::cout.flush();
+                std::cerr.flush();
+                std::fflush(stdout);
+                std::fflush(stderr);
+            }
+
+            // Файл, унаследованный через fork, делит смещение с родителем
+            // и соседними рабочими — у каждого процесса должен быть свой
+            void reopen()
+            {
+                if (m_file >= 0)
+                    ::close(m_file);
+                m_file = create_file();
+                m_owner = ::getpid();
+            }
+
+            void restore()
+            {
+                if (m_saved_out >= 0)
+                {
+                    ::dup2(m_saved_out, 1);
+                    ::close(m_saved_out);
+                }
+                if (m_saved_err >= 0)
+                {
+                    ::dup2(m_saved_err, 2);
+                    ::close(m_saved_err);
+                }
+                m_saved_out = -1;
+                m_saved_err = -1;
+            }
+
+            int m_file = -1;
+            int m_saved_out = -1;
+            int m_saved_err = -1;
+            pid_t m_owner = 0;
+        };
+
+        inline FdCapture &fd_capture()
+        {
+            static FdCapture capture;
+            return capture;
+        }
+#endif
+    } // namespace detail
+} // namespace guard
@@ -2,12 +2,128 @@
 #ifndef GUARD_CHECK_H
 #define GUARD_CHECK_H
 
+#include "diff.h"
 #include "env.h"
 #include "location.h"
 #include "macro.h"
 
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <ostream>
 #include <sstream>
 #include <string>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#include <type_traits>
+#include <utility>
+
+namespace guard
+{
+    namespace detail
+    {
+        // Есть ли у типа operator<< в std::ostream
+        template <typename T>
+        class is_streamable
+        {
+            template <typename U>
+            static auto test(int)
+                -> decltype(std::declval<std::ostream &>() << std::declval<const U &>(),
+                            std::true_type());
+            template <typename>
+            static std::false_type test(...);
+
+        public:
+            static const bool value = decltype(test<T>(0))::value;
+        };
+
+        // Можно ли обойти значение как диапазон (begin/end)
+        template <typename T>
+        class is_range
+        {
+            template <typename U>
+            static auto test(int)
+                -> decltype(std::begin(std::declval<const U &>()) !=
+                                std::end(std::declval<const U &>()),
+                            std::true_type());
+            template <typename>
+            static std::false_type test(...);
+
+        public:
+            static const bool value = decltype(test<T>(0))::value;
+        };
+
+        // Сколько элементов диапазона печатать в сообщении о провале
+        const std::size_t printable_range_limit = 16;
+
+        template <typename T>
+        void print_value(std::ostream &os, const T &value);
+
+        template <typename T, typename IsRange>
+        void print_value(std::ostream &os, const T &value, std::true_type, IsRange)
+        {
+            os << value;
+        }
+
+        template <typename T>
+        void print_value(std::ostream &os, const T &value, std::false_type, std::true_type)
+        {
+            std::size_t count = 0;
+            os << "{";
+            for (auto it = std::begin(value); it != std::end(value); ++it, ++count)
+            {
+                if (count == printable_range_limit)
+                {
+                    os << ", ...";
+                    for (++it; it != std::end(value); ++it)
+                        ++count;
+                    os << " (" << count + 1 << " elements)";
+                    break;
+                }
+                if (count > 0)
+                    os << ", ";
+                print_value(os, *it);
+            }
+            os << "}";
+        }
+
+        template <typename T>
+        void print_value(std::ostream &os, const T &, std::false_type, std::false_type)
+        {
+            os << "{?}";
+        }
+
+        template <typename T>
+        void print_value(std::ostream &os, const T &value)
+        {
+            print_value(os, value,
+                        std::integral_constant<bool, is_streamable<T>::value>(),
+                        std::integral_constant<bool, is_range<T>::value>());
+        }
+
+        // Ссылка на операнд проверки; форматируется только при провале.
+        // Типы без operator<< печатаются как диапазон или "{?}"
+        template <typename T>
+        struct Printable
+        {
+            const T &value;
+        };
+
+        template <typename T>
+        Printable<T> printable(const T &value)
+        {
+            return Printable<T>{value};
+        }
+
+        template <typename T>
+        std::ostream &operator<<(std::ostream &os, const Printable<T> &p)
+        {
+            print_value(os, p.value);
+            return os;
+        }
+    } // namespace detail
+} // namespace guard
 
 static inline std::string guard_location_part(struct guard_location loc)
 {
@@ -19,19 +135,187 @@ static inline std::string guard_location_part(struct guard_location loc)
     return os.str();
 }
 
+namespace guard
+{
+    namespace detail
+    {
+        // Форматирует значение в арену теста; состояние потока
+        // сбрасывается, как у нового ostringstream
+        template <typename T>
+        const char *format_to_arena(guard_check_env_t &env, const T &value)
+        {
+            std::ostream &os = env.value_stream;
+            os.clear();
+            os.flags(std::ios_base::skipws | std::ios_base::dec);
+            os.precision(6);
+            os.width(0);
+            os.fill(' ');
+            env.value_buf.start(&env.arena);
+            os << printable(value);
+            return env.value_buf.finish();
+        }
+
+        // Операнд как текст для диффа: std::string и std::string_view —
+        // сильные (strength 2), const char * и массивы char — слабые (1).
+        // Дифф строится, если хоть один операнд сильный, а второй — текст:
+        // сравнение двух указателей остаётся сравнением указателей
+        template <typename T>
+        struct text_of
+        {
+            static const int strength = 0;
+        };
+
+        template <>
+        struct text_of<std::string>
+        {
+            static const int strength = 2;
+            static guard::diff::Text get(const std::string &s)
+            {
+                return guard::diff::Text{s.data(), s.size()};
+            }
+        };
+
+#if __cplusplus >= 201703L
+        template <>
+        struct text_of<std::string_view>
+        {
+            static const int strength = 2;
+            static guard::diff::Text get(std::string_view s)
+            {
+                return guard::diff::Text{s.data(), s.size()};
+            }
+        };
+#endif
+
+        template <>
+        struct text_of<const char *>
+        {
+            static const int strength = 1;
+            static guard::diff::Text get(const char *s)
+            {
+                return s ? guard::diff::Text{s, std::strlen(s)} : guard::diff::Text{"", 0};
+            }
+        };
+
+        template <>
+        struct text_of<char *> : text_of<const char *>
+        {
+        };
+
+        template <std::size_t N>
+        struct text_of<char[N]>
+        {
+            static const int strength = 1;
+            static guard::diff::Text get(const char (&s)[N])
+            {
+                const void *end = std::memchr(s, '\0', N);
+                return guard::diff::Text{s, end ? static_cast<std::size_t>(static_cast<const char *>(end) - s) : N};
+            }
+        };
+
+        template <std::size_t N>
+        struct text_of<const char[N]> : text_of<char[N]>
+        {
+        };
+
+        template <typename L, typename R>
+        void format_operands(guard_check_env_t &env, guard_failure_record &record,
+                             const L &lhs, const R &rhs, std::false_type)
+        {
+            record.lhs = format_to_arena(env, lhs);
+            record.rhs = format_to_arena(env, rhs);
+        }
+
+        // Длинные и многострочные строки: в left/right — начало и размер,
+        // в detail — ограниченный дифф вместо текста целиком
+        template <typename L, typename R>
+        void format_operands(guard_check_env_t &env, guard_failure_record &record,
+                             const L &lhs, const R &rhs, std::true_type)
+        {
+            const guard::diff::Text a = text_of<L>::get(lhs);
+            const guard::diff::Text b = text_of<R>::get(rhs);
+            if (!guard::diff::worth_diff(a, b))
+            {
+                format_operands(env, record, lhs, rhs, std::false_type());
+                return;
+            }
+            record.lhs = env.arena.copy(guard::diff::summary(a));
+            record.rhs = env.arena.copy(guard::diff::summary(b));
+            record.detail = env.arena.copy(guard::diff::render(a, b));
+        }
+    } // namespace detail
+} // namespace guard
+
+// Отчёты о провале вынесены в холодные невстраиваемые функции: на месте
+// проверки остаются только сравнение, счётчик и ветвление.
+
+// Запись провала без операндов. Выше лимита мягкий провал только
+// считается, сообщение не форматируется. Жёсткий провал прерывает тест
+GUARD_COLD inline void guard_check_report(const guard_location &loc, const char *cond, bool fatal)
+{
+    if (guard_check_env_reserve_record(fatal))
+    {
+        guard_failure_record record = {};
+        record.loc = loc;
+        record.cond = cond;
+        guard_check_env().failures.push_back(record);
+    }
+    if (fatal)
+        GUARD_CHECK_ENV_RAISE_IMPL();
+}
+
+// Запись провала сравнения: значения операндов форматируются в арену.
+// Так же отчитываются проверки, которые передают готовое описание
+// провала левым операндом (CHECK_RANGE_EQ, CHECK_COMPLEXITY и т.п.)
+template <typename L, typename R>
+GUARD_COLD void guard_check_report_binary(const guard_location &loc, const char *cond,
+                                          const L &lhs, const R &rhs, bool fatal)
+{
+    if (guard_check_env_reserve_record(fatal))
+    {
+        guard_check_env_t &env = guard_check_env();
+        guard_failure_record record = {};
+        record.loc = loc;
+        record.cond = cond;
+        guard::detail::format_operands(env, record, lhs, rhs, std::false_type());
+        env.failures.push_back(record);
+    }
+    if (fatal)
+        GUARD_CHECK_ENV_RAISE_IMPL();
+}
+
+// Запись провала равенства (CHECK_EQ, REQUIRE_EQ): длинные строки
+// сравниваемых значений заменяются диффом
+template <typename L, typename R>
+GUARD_COLD void guard_check_report_equal(const guard_location &loc, const char *cond,
+                                         const L &lhs, const R &rhs, bool fatal)
+{
+    if (guard_check_env_reserve_record(fatal))
+    {
+        guard_check_env_t &env = guard_check_env();
+        guard_failure_record record = {};
+        record.loc = loc;
+        record.cond = cond;
+        guard::detail::format_operands(
+            env, record, lhs, rhs,
+            std::integral_constant<bool, guard::detail::text_of<L>::strength +
+                                             guard::detail::text_of<R>::strength >= 3>());
+        env.failures.push_back(record);
+    }
+    if (fatal)
+        GUARD_CHECK_ENV_RAISE_IMPL();
+}
+
 // Базовый CHECK: выражение должно быть истинным (мягкий, не рвёт тест)
 #define GUARD_CHECK(expr)                                                      \
     do                                                                         \
     {                                                                          \
         const bool _guard_ok = static_cast<bool>(expr);                        \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc)                              \
-                      << "\tcond:" << GUARD_STRINGIFY(expr) << "\n\f";         \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report(loc, GUARD_STRINGIFY(expr), false);             \
         }                                                                      \
     } while (0)
 
@@ -41,14 +325,10 @@ static inline std::string guard_location_part(struct guard_location loc)
     {                                                                          \
         const bool _guard_ok = static_cast<bool>(expr);                        \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc)                              \
-                      << "\tcond:" << GUARD_STRINGIFY(expr) << "\n\f";         \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
-            GUARD_CHECK_ENV_RAISE_IMPL();                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report(loc, GUARD_STRINGIFY(expr), true);              \
         }                                                                      \
     } while (0)
 
@@ -58,13 +338,10 @@ static inline std::string guard_location_part(struct guard_location loc)
     {                                                                          \
         const bool _guard_ok = !(expr);                                        \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond: !"               \
-                      << GUARD_STRINGIFY(expr) << "\n\f";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report(loc, " !" GUARD_STRINGIFY(expr), false);        \
         }                                                                      \
     } while (0)
 
@@ -74,14 +351,10 @@ static inline std::string guard_location_part(struct guard_location loc)
     {                                                                          \
         const bool _guard_ok = !(expr);                                        \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond: !"               \
-                      << GUARD_STRINGIFY(expr) << "\n\f";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
-            GUARD_CHECK_ENV_RAISE_IMPL();                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report(loc, " !" GUARD_STRINGIFY(expr), true);         \
         }                                                                      \
     } while (0)
 
@@ -89,19 +362,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_CHECK_EQ(a, b)                                                   \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a == _guard_b);                         \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " == " GUARD_STRINGIFY(b) << "\n"  \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_equal(                                          \
+                loc, GUARD_STRINGIFY(a) " == " GUARD_STRINGIFY(b),             \
+                _guard_a, _guard_b, false);                                    \
         }                                                                      \
     } while (0)
 
@@ -109,20 +379,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_REQUIRE_EQ(a, b)                                                 \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a == _guard_b);                         \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " == " GUARD_STRINGIFY(b) << "\n"  \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
-            GUARD_CHECK_ENV_RAISE_IMPL();                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_equal(                                          \
+                loc, GUARD_STRINGIFY(a) " == " GUARD_STRINGIFY(b),             \
+                _guard_a, _guard_b, true);                                     \
         }                                                                      \
     } while (0)
 
@@ -130,19 +396,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_CHECK_NEQ(a, b)                                                  \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a != _guard_b);                         \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " != " GUARD_STRINGIFY(b) << "\n"  \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, GUARD_STRINGIFY(a) " != " GUARD_STRINGIFY(b),             \
+                _guard_a, _guard_b, false);                                    \
         }                                                                      \
     } while (0)
 
@@ -150,20 +413,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_REQUIRE_NEQ(a, b)                                                \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a != _guard_b);                         \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " != " GUARD_STRINGIFY(b) << "\n"  \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
-            GUARD_CHECK_ENV_RAISE_IMPL();                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, GUARD_STRINGIFY(a) " != " GUARD_STRINGIFY(b),             \
+                _guard_a, _guard_b, true);                                     \
         }                                                                      \
     } while (0)
 
@@ -171,19 +430,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_CHECK_LT(a, b)                                                   \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a < _guard_b);                          \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " < " GUARD_STRINGIFY(b) << "\n"   \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, GUARD_STRINGIFY(a) " < " GUARD_STRINGIFY(b),              \
+                _guard_a, _guard_b, false);                                    \
         }                                                                      \
     } while (0)
 
@@ -191,20 +447,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_REQUIRE_LT(a, b)                                                 \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a < _guard_b);                          \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " < " GUARD_STRINGIFY(b) << "\n"   \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
-            GUARD_CHECK_ENV_RAISE_IMPL();                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, GUARD_STRINGIFY(a) " < " GUARD_STRINGIFY(b),              \
+                _guard_a, _guard_b, true);                                     \
         }                                                                      \
     } while (0)
 
@@ -212,19 +464,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_CHECK_GT(a, b)                                                   \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a > _guard_b);                          \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " > " GUARD_STRINGIFY(b) << "\n"   \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, GUARD_STRINGIFY(a) " > " GUARD_STRINGIFY(b),              \
+                _guard_a, _guard_b, false);                                    \
         }                                                                      \
     } while (0)
 
@@ -232,20 +481,16 @@ static inline std::string guard_location_part(struct guard_location loc)
 #define GUARD_REQUIRE_GT(a, b)                                                 \
     do                                                                         \
     {                                                                          \
-        const auto _guard_a = (a);                                            \
-        const auto _guard_b = (b);                                            \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
         const bool _guard_ok = (_guard_a > _guard_b);                          \
         GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
-        if (!_guard_ok)                                                        \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
         {                                                                      \
-            GUARD_CURRENT_LOCATION(loc);                                       \
-            std::ostringstream _guard_os;                                      \
-            _guard_os << guard_location_part(loc) << "\tcond:"                 \
-                      << GUARD_STRINGIFY(a) " > " GUARD_STRINGIFY(b) << "\n"   \
-                      << "\tleft: " << _guard_a << "\n"                        \
-                      << "\tright: " << _guard_b << "\n";                      \
-            GUARD_CHECK_ENV_APPEND(_guard_os.str());                           \
-            GUARD_CHECK_ENV_RAISE_IMPL();                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, GUARD_STRINGIFY(a) " > " GUARD_STRINGIFY(b),              \
+                _guard_a, _guard_b, true);                                     \
         }                                                                      \
     } while (0)
 
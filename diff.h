@@ -0,0 +1,624 @@
+// guard/diff.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Дифф строк для сообщений о провале CHECK_EQ на std::string.
+//
+// Текст с переводами строк сравнивается по строкам, без них — по байтам.
+// Общие начало и конец отрезаются за линейное время, остаток сравнивается
+// алгоритмом Майерса с поиском средней змеи (память O(N + M)). Работа
+// ограничена: после settings().max_work сравнений оставшиеся участки
+// сводятся жадно — от каждого расхождения ищется ближайшая точка, где
+// тексты снова совпадают, в окне из resync_window токенов. Найденные к
+// этому моменту отличия остаются точными. Вывод тоже ограничен — max_lines строк не
+// длиннее max_width, поэтому сообщение остаётся маленьким при любых
+// размерах входа.
+
+namespace guard
+{
+    namespace diff
+    {
+        struct Settings
+        {
+            // Строк контекста вокруг изменения (--diff-context); в
+            // побайтовом режиме — по 8 байт на строку
+            std::size_t context = 3;
+            // Строк диффа в сообщении
+            std::size_t max_lines = 40;
+            // Длина одной строки диффа
+            std::size_t max_width = 160;
+            // Предел сравнений строк (байт) при поиске изменений
+            std::size_t max_work = 20000000;
+        };
+
+        inline Settings &settings()
+        {
+            static Settings instance;
+            return instance;
+        }
+
+        // Текст без владения
+        struct Text
+        {
+            const char *data;
+            std::size_t size;
+        };
+
+        namespace detail
+        {
+            enum Kind
+            {
+                Equal,
+                Delete,
+                Insert
+            };
+
+            // Участок сценария правки: count токенов с позиции a (Equal,
+            // Delete) и/или b (Equal, Insert)
+            struct Edit
+            {
+                Kind kind;
+                std::size_t a;
+                std::size_t b;
+                std::size_t count;
+            };
+
+            // Окно поиска точки схождения после исчерпания работы, токенов
+            // с каждой стороны: до resync_window^2 сравнений на расхождение
+            const std::size_t resync_window = 64;
+
+            // Строки текста без '\n'; хеш ускоряет сравнение
+            class Lines
+            {
+            public:
+                explicit Lines(const Text &text) : m_data(text.data)
+                {
+                    std::size_t begin = 0;
+                    for (std::size_t i = 0; i <= text.size; ++i)
+                    {
+                        if (i < text.size && text.data[i] != '\n')
+                            continue;
+                        if (i == text.size && begin == text.size && i > 0)
+                            break;
+                        Line line = {begin, i - begin, hash(text.data + begin, i - begin)};
+                        m_lines.push_back(line);
+                        begin = i + 1;
+                    }
+                }
+
+                std::size_t size() const
+                {
+                    return m_lines.size();
+                }
+
+                bool equal(std::size_t i, const Lines &other, std::size_t j) const
+                {
+                    const Line &x = m_lines[i];
+                    const Line &y = other.m_lines[j];
+                    return x.hash == y.hash && x.size == y.size &&
+                           std::memcmp(m_data + x.begin, other.m_data + y.begin, x.size) == 0;
+                }
+
+                Text line(std::size_t i) const
+                {
+                    return Text{m_data + m_lines[i].begin, m_lines[i].size};
+                }
+
+            private:
+                struct Line
+                {
+                    std::size_t begin;
+                    std::size_t size;
+                    std::uint64_t hash;
+                };
+
+                static std::uint64_t hash(const char *data, std::size_t size)
+                {
+                    std::uint64_t h = 14695981039346656037ull;
+                    for (std::size_t i = 0; i < size; ++i)
+                        h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+                    return h;
+                }
+
+                const char *m_data;
+                std::vector<Line> m_lines;
+            };
+
+            class Bytes
+            {
+            public:
+                explicit Bytes(const Text &text) : m_text(text)
+                {
+                }
+
+                std::size_t size() const
+                {
+                    return m_text.size;
+                }
+
+                bool equal(std::size_t i, const Bytes &other, std::size_t j) const
+                {
+                    return m_text.data[i] == other.m_text.data[j];
+                }
+
+            private:
+                Text m_text;
+            };
+
+            // Сценарий правки a -> b (Myers, "An O(ND) difference algorithm",
+            // делением пополам по средней змее)
+            template <typename Seq>
+            class Differ
+            {
+            public:
+                Differ(const Seq &a, const Seq &b, std::size_t max_work)
+                    : m_a(a), m_b(b), m_work(max_work)
+                {
+                }
+
+                std::vector<Edit> run()
+                {
+                    diff(0, m_a.size(), 0, m_b.size());
+                    return m_edits;
+                }
+
+            private:
+                bool equal(std::size_t i, std::size_t j) const
+                {
+                    return m_a.equal(i, m_b, j);
+                }
+
+                void emit(Kind kind, std::size_t a, std::size_t b, std::size_t count)
+                {
+                    if (count == 0)
+                        return;
+                    if (kind == Delete && !m_edits.empty() && m_edits.back().kind == Insert)
+                    {
+                        // Удаление выводится перед соседней вставкой
+                        Edit insert = m_edits.back();
+                        m_edits.pop_back();
+                        emit(Delete, a, insert.b, count);
+                        insert.a = a + count;
+                        m_edits.push_back(insert);
+                        return;
+                    }
+                    if (!m_edits.empty() && m_edits.back().kind == kind)
+                    {
+                        m_edits.back().count += count;
+                        return;
+                    }
+                    Edit edit = {kind, a, b, count};
+                    m_edits.push_back(edit);
+                }
+
+                void replace(std::size_t a0, std::size_t a1, std::size_t b0, std::size_t b1)
+                {
+                    emit(Delete, a0, b0, a1 - a0);
+                    emit(Insert, a1, b0, b1 - b0);
+                }
+
+                void diff(std::size_t a0, std::size_t a1, std::size_t b0, std::size_t b1)
+                {
+                    std::size_t prefix = 0;
+                    while (a0 + prefix < a1 && b0 + prefix < b1 && equal(a0 + prefix, b0 + prefix))
+                        ++prefix;
+                    emit(Equal, a0, b0, prefix);
+                    a0 += prefix;
+                    b0 += prefix;
+
+                    std::size_t suffix = 0;
+                    while (a1 - suffix > a0 && b1 - suffix > b0 &&
+                           equal(a1 - suffix - 1, b1 - suffix - 1))
+                        ++suffix;
+                    a1 -= suffix;
+                    b1 -= suffix;
+
+                    if (a0 == a1 || b0 == b1)
+                        replace(a0, a1, b0, b1);
+                    else if (m_work == 0)
+                        resync(a0, a1, b0, b1);
+                    else
+                        bisect(a0, a1, b0, b1);
+                    emit(Equal, a1, b1, suffix);
+                }
+
+                // Встречный поиск из начала и из конца; на пересечении
+                // путей участок делится на две независимые задачи
+                void bisect(std::size_t a0, std::size_t a1, std::size_t b0, std::size_t b1)
+                {
+                    const long n = static_cast<long>(a1 - a0);
+                    const long m = static_cast<long>(b1 - b0);
+                    const long max_d = std::min<long>((n + m + 1) / 2, 1L << 16);
+                    const long offset = max_d + 1;
+                    std::vector<long> v1(static_cast<std::size_t>(2 * max_d + 3), -1);
+                    std::vector<long> v2(v1.size(), -1);
+                    v1[offset + 1] = 0;
+                    v2[offset + 1] = 0;
+                    const long delta = n - m;
+                    const bool front = (delta % 2) != 0;
+                    long k1start = 0, k1end = 0, k2start = 0, k2end = 0;
+                    for (long d = 0; d < max_d && m_work > 0; ++d)
+                    {
+                        for (long k1 = -d + k1start; k1 <= d - k1end; k1 += 2)
+                        {
+                            const long k1_offset = offset + k1;
+                            long x1 = (k1 == -d || (k1 != d && v1[k1_offset - 1] < v1[k1_offset + 1]))
+                                          ? v1[k1_offset + 1]
+                                          : v1[k1_offset - 1] + 1;
+                            long y1 = x1 - k1;
+                            const long x1_start = x1;
+                            while (x1 < n && y1 < m && equal(a0 + x1, b0 + y1))
+                            {
+                                ++x1;
+                                ++y1;
+                            }
+                            m_work -= std::min<std::size_t>(m_work, static_cast<std::size_t>(x1 - x1_start) + 1);
+                            v1[k1_offset] = x1;
+                            if (x1 > n)
+                                k1end += 2;
+                            else if (y1 > m)
+                                k1start += 2;
+                            else if (front)
+                            {
+                                const long k2_offset = offset + delta - k1;
+                                if (k2_offset >= 0 && k2_offset < static_cast<long>(v2.size()) &&
+                                    v2[k2_offset] != -1 && x1 >= n - v2[k2_offset])
+                                {
+                                    split(a0, a1, b0, b1, x1, y1);
+                                    return;
+                                }
+                            }
+                        }
+                        for (long k2 = -d + k2start; k2 <= d - k2end; k2 += 2)
+                        {
+                            const long k2_offset = offset + k2;
+                            long x2 = (k2 == -d || (k2 != d && v2[k2_offset - 1] < v2[k2_offset + 1]))
+                                          ? v2[k2_offset + 1]
+                                          : v2[k2_offset - 1] + 1;
+                            long y2 = x2 - k2;
+                            const long x2_start = x2;
+                            while (x2 < n && y2 < m && equal(a0 + (n - x2 - 1), b0 + (m - y2 - 1)))
+                            {
+                                ++x2;
+                                ++y2;
+                            }
+                            m_work -= std::min<std::size_t>(m_work, static_cast<std::size_t>(x2 - x2_start) + 1);
+                            v2[k2_offset] = x2;
+                            if (x2 > n)
+                                k2end += 2;
+                            else if (y2 > m)
+                                k2start += 2;
+                            else if (!front)
+                            {
+                                const long k1_offset = offset + delta - k2;
+                                if (k1_offset >= 0 && k1_offset < static_cast<long>(v1.size()) &&
+                                    v1[k1_offset] != -1)
+                                {
+                                    const long x1 = v1[k1_offset];
+                                    const long y1 = offset + x1 - k1_offset;
+                                    if (x1 >= n - x2)
+                                    {
+                                        split(a0, a1, b0, b1, x1, y1);
+                                        return;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                    // Путь не нашёлся в пределах работы
+                    resync(a0, a1, b0, b1);
+                }
+
+                // Жадное сведение без бюджета: после общего начала ищется
+                // ближайшая по i + j пара a[i] == b[j] в окне resync_window;
+                // всё до неё — замена, дальше снова общее начало. Сценарий
+                // может быть не кратчайшим, но совпавшие токены не попадают
+                // в изменения, а работа линейна по длине участка
+                void resync(std::size_t a0, std::size_t a1, std::size_t b0, std::size_t b1)
+                {
+                    while (a0 < a1 && b0 < b1)
+                    {
+                        std::size_t same = 0;
+                        while (a0 + same < a1 && b0 + same < b1 && equal(a0 + same, b0 + same))
+                            ++same;
+                        emit(Equal, a0, b0, same);
+                        a0 += same;
+                        b0 += same;
+                        if (a0 == a1 || b0 == b1)
+                            break;
+
+                        const std::size_t wa = std::min(resync_window, a1 - a0);
+                        const std::size_t wb = std::min(resync_window, b1 - b0);
+                        std::size_t skip_a = wa;
+                        std::size_t skip_b = wb;
+                        for (std::size_t sum = 1; sum < wa + wb && skip_a == wa; ++sum)
+                        {
+                            const std::size_t first = sum > wb - 1 ? sum - (wb - 1) : 0;
+                            for (std::size_t i = first; i <= sum && i < wa; ++i)
+                            {
+                                if (equal(a0 + i, b0 + (sum - i)))
+                                {
+                                    skip_a = i;
+                                    skip_b = sum - i;
+                                    break;
+                                }
+                            }
+                        }
+                        replace(a0, a0 + skip_a, b0, b0 + skip_b);
+                        a0 += skip_a;
+                        b0 += skip_b;
+                    }
+                    replace(a0, a1, b0, b1);
+                }
+
+                void split(std::size_t a0, std::size_t a1, std::size_t b0, std::size_t b1,
+                           long x, long y)
+                {
+                    const std::size_t am = a0 + static_cast<std::size_t>(x);
+                    const std::size_t bm = b0 + static_cast<std::size_t>(y);
+                    diff(a0, am, b0, bm);
+                    diff(am, a1, bm, b1);
+                }
+
+                const Seq &m_a;
+                const Seq &m_b;
+                std::size_t m_work;
+                std::vector<Edit> m_edits;
+            };
+
+            // Видимая запись байтов: управляющие символы экранируются
+            inline void append_escaped(std::string &out, const char *data, std::size_t size)
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    const unsigned char c = static_cast<unsigned char>(data[i]);
+                    if (c == '\n')
+                        out += "\\n";
+                    else if (c == '\t')
+                        out += "\\t";
+                    else if (c == '\r')
+                        out += "\\r";
+                    else if (c < 0x20 || c == 0x7f)
+                    {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\x%02x", c);
+                        out += buf;
+                    }
+                    else
+                        out += static_cast<char>(c);
+                }
+            }
+
+            // Не больше limit байт текста; обрезанное помечается размером
+            inline void append_clipped(std::string &out, const char *data, std::size_t size,
+                                       std::size_t limit)
+            {
+                if (size <= limit)
+                {
+                    append_escaped(out, data, size);
+                    return;
+                }
+                append_escaped(out, data, limit);
+                out += "...(" + std::to_string(size) + " bytes)";
+            }
+
+            inline void push_line(std::vector<std::string> &out, std::string line,
+                                  std::size_t max_width)
+            {
+                if (line.size() > max_width)
+                {
+                    line.resize(max_width - 3);
+                    line += "...";
+                }
+                out.push_back("\t" + line + "\n");
+            }
+
+            // Группы изменений [first, last) по сценарию; группы, между
+            // которыми не больше 2 * context общих токенов, сливаются
+            inline std::vector<std::pair<std::size_t, std::size_t>>
+            hunks(const std::vector<Edit> &edits, std::size_t context)
+            {
+                std::vector<std::pair<std::size_t, std::size_t>> result;
+                for (std::size_t i = 0; i < edits.size(); ++i)
+                {
+                    if (edits[i].kind == Equal)
+                        continue;
+                    if (!result.empty() && result.back().second + 1 == i &&
+                        edits[i - 1].count <= 2 * context)
+                        result.back().second = i + 1;
+                    else if (!result.empty() && result.back().second == i)
+                        result.back().second = i + 1;
+                    else
+                        result.push_back(std::make_pair(i, i + 1));
+                }
+                return result;
+            }
+
+            inline std::string finish(const std::vector<std::string> &lines, std::size_t changed,
+                                      std::size_t shown, const char *unit)
+            {
+                std::string out;
+                for (const std::string &line : lines)
+                    out += line;
+                if (changed > shown)
+                    out += "\t... " + std::to_string(changed - shown) + " more changed " + unit +
+                           "\n";
+                return out;
+            }
+
+            // Построчный дифф в виде unified diff
+            inline std::string render_lines(const Text &a, const Text &b, const Settings &config)
+            {
+                const Lines la(a);
+                const Lines lb(b);
+                const std::vector<Edit> edits = Differ<Lines>(la, lb, config.max_work).run();
+                std::vector<std::string> out;
+                std::size_t changed = 0;
+                std::size_t shown = 0;
+                for (const Edit &e : edits)
+                    changed += e.kind == Equal ? 0 : e.count;
+
+                for (const auto &h : hunks(edits, config.context))
+                {
+                    if (out.size() >= config.max_lines)
+                        break;
+                    const Edit &first = edits[h.first];
+                    const Edit &last = edits[h.second - 1];
+                    const std::size_t before = h.first > 0 ? std::min(config.context, edits[h.first - 1].count) : 0;
+                    const std::size_t after = h.second < edits.size() ? std::min(config.context, edits[h.second].count) : 0;
+                    const std::size_t a_begin = first.a - before;
+                    const std::size_t b_begin = first.b - before;
+                    const std::size_t a_end = (last.kind == Delete ? last.a + last.count : last.a) + after;
+                    const std::size_t b_end = (last.kind == Insert ? last.b + last.count : last.b) + after;
+                    push_line(out,
+                              "@@ -" + std::to_string(a_begin + 1) + "," + std::to_string(a_end - a_begin) +
+                                  " +" + std::to_string(b_begin + 1) + "," + std::to_string(b_end - b_begin) +
+                                  " @@",
+                              config.max_width);
+
+                    std::size_t a_pos = a_begin;
+                    std::size_t b_pos = b_begin;
+                    const auto context_line = [&](std::size_t count) {
+                        for (std::size_t k = 0; k < count && out.size() < config.max_lines; ++k)
+                        {
+                            const Text t = la.line(a_pos + k);
+                            std::string line = " ";
+                            append_escaped(line, t.data, std::min(t.size, config.max_width));
+                            push_line(out, line, config.max_width);
+                        }
+                        a_pos += count;
+                        b_pos += count;
+                    };
+                    context_line(before);
+                    for (std::size_t i = h.first; i < h.second; ++i)
+                    {
+                        const Edit &e = edits[i];
+                        if (e.kind == Equal)
+                        {
+                            context_line(e.count);
+                            continue;
+                        }
+                        const Lines &side = e.kind == Delete ? la : lb;
+                        std::size_t &pos = e.kind == Delete ? a_pos : b_pos;
+                        // Замене, не влезающей в отчёт, — поровну "-" и "+"
+                        const std::size_t room = config.max_lines - std::min(config.max_lines, out.size());
+                        std::size_t limit = room;
+                        if (e.kind == Delete && i + 1 < h.second && edits[i + 1].kind == Insert)
+                            limit = room - std::min(edits[i + 1].count, room / 2);
+                        for (std::size_t k = 0; k < e.count; ++k)
+                        {
+                            if (k < limit && out.size() < config.max_lines)
+                            {
+                                const Text t = side.line(pos + k);
+                                std::string line = e.kind == Delete ? "-" : "+";
+                                append_escaped(line, t.data, std::min(t.size, config.max_width));
+                                push_line(out, line, config.max_width);
+                                ++shown;
+                            }
+                        }
+                        pos += e.count;
+                    }
+                    context_line(after);
+                }
+                if (changed == 0)
+                    out.push_back("\t(lines are equal, texts differ in the final newline)\n");
+                return finish(out, changed, shown, "lines");
+            }
+
+            // Побайтовый дифф: строка на группу изменений,
+            // "@@ byte 120 @@ ...общее[-было-]{+стало+}общее..."
+            inline std::string render_bytes(const Text &a, const Text &b, const Settings &config)
+            {
+                const Bytes ba(a);
+                const Bytes bb(b);
+                const std::vector<Edit> edits = Differ<Bytes>(ba, bb, config.max_work).run();
+                const std::size_t context = config.context * 8;
+                const std::size_t piece = config.max_width / 3;
+                std::vector<std::string> out;
+                std::size_t changed = 0;
+                std::size_t shown = 0;
+                for (const Edit &e : edits)
+                    changed += e.kind == Equal ? 0 : 1;
+
+                for (const auto &h : hunks(edits, context))
+                {
+                    if (out.size() >= config.max_lines)
+                        break;
+                    std::string line = "@@ byte " + std::to_string(edits[h.first].a) + " @@ ";
+                    if (h.first > 0)
+                    {
+                        const Edit &e = edits[h.first - 1];
+                        const std::size_t count = std::min(context, e.count);
+                        if (count < e.count)
+                            line += "...";
+                        append_escaped(line, a.data + e.a + e.count - count, count);
+                    }
+                    for (std::size_t i = h.first; i < h.second; ++i)
+                    {
+                        const Edit &e = edits[i];
+                        if (e.kind == Equal)
+                            append_escaped(line, a.data + e.a, e.count);
+                        else
+                        {
+                            line += e.kind == Delete ? "[-" : "{+";
+                            append_clipped(line, (e.kind == Delete ? a.data + e.a : b.data + e.b),
+                                           e.count, piece);
+                            line += e.kind == Delete ? "-]" : "+}";
+                            ++shown;
+                        }
+                    }
+                    if (h.second < edits.size())
+                    {
+                        const Edit &e = edits[h.second];
+                        const std::size_t count = std::min(context, e.count);
+                        append_escaped(line, a.data + e.a, count);
+                        if (count < e.count)
+                            line += "...";
+                    }
+                    push_line(out, line, config.max_width);
+                }
+                return finish(out, changed, shown, "regions");
+            }
+        } // namespace detail
+
+        // Дифф нужен, если хоть одна строка длинная или многострочная;
+        // короткие строки печатаются целиком, как раньше
+        inline bool worth_diff(const Text &a, const Text &b)
+        {
+            const std::size_t short_text = 80;
+            return a.size > short_text || b.size > short_text ||
+                   std::memchr(a.data, '\n', a.size) || std::memchr(b.data, '\n', b.size);
+        }
+
+        // "\"начало текста...\" (2345678 bytes, 40000 lines)"
+        inline std::string summary(const Text &text)
+        {
+            std::string out = "\"";
+            const std::size_t limit = 60;
+            detail::append_escaped(out, text.data, std::min(limit, text.size));
+            out += text.size > limit ? "...\" (" : "\" (";
+            const std::size_t breaks =
+                static_cast<std::size_t>(std::count(text.data, text.data + text.size, '\n'));
+            out += std::to_string(text.size) + (text.size == 1 ? " byte" : " bytes");
+            if (breaks > 0)
+                out += ", " + std::to_string(breaks + (text.data[text.size - 1] != '\n')) + " lines";
+            return out + ")";
+        }
+
+        // Строки диффа a -> b, каждая с '\t' в начале и '\n' в конце
+        inline std::string render(const Text &a, const Text &b)
+        {
+            const Settings &config = settings();
+            if (std::memchr(a.data, '\n', a.size) || std::memchr(b.data, '\n', b.size))
+                return detail::render_lines(a, b, config);
+            return detail::render_bytes(a, b, config);
+        }
+    } // namespace diff
+} // namespace guard
@@ -1,40 +1,327 @@
 // guard/check/env.h
 #pragma once
 
+#include "location.h"
+
+#include <cstddef>
+#include <cstring>
 #include <exception>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
 #include <string>
+#include <vector>
+
+namespace guard
+{
+    namespace detail
+    {
+        // Арена строк для записей о провалах: блоки по 64 KiB, которые
+        // между тестами не освобождаются, а переиспользуются. Строка
+        // собирается посимвольно (put/write) и закрывается finish().
+        class Arena
+        {
+        public:
+            static const std::size_t block_size = 64 * 1024;
+
+            void put(char c)
+            {
+                if (m_used == m_capacity)
+                    grow(1);
+                m_blocks[m_current][m_used++] = c;
+            }
+
+            void write(const char *data, std::size_t size)
+            {
+                if (m_capacity - m_used < size)
+                    grow(size);
+                std::memcpy(m_blocks[m_current].get() + m_used, data, size);
+                m_used += size;
+            }
+
+            // Завершает текущую строку и возвращает указатель на неё;
+            // указатель живёт до reset()
+            const char *finish()
+            {
+                put('\0');
+                const char *result = m_blocks[m_current].get() + m_start;
+                m_start = m_used;
+                return result;
+            }
+
+            const char *copy(const char *data, std::size_t size)
+            {
+                write(data, size);
+                return finish();
+            }
+
+            const char *copy(const std::string &text)
+            {
+                return copy(text.data(), text.size());
+            }
+
+            // Позиция между строками; rewind() отбрасывает всё, что
+            // записано после неё, а блоки остаются за ареной
+            struct Mark
+            {
+                std::size_t block;
+                std::size_t used;
+            };
+
+            Mark mark() const
+            {
+                return Mark{m_current, m_start};
+            }
+
+            void rewind(const Mark &mark)
+            {
+                m_current = mark.block;
+                m_used = mark.used;
+                m_start = mark.used;
+                m_capacity = m_sizes.empty() ? 0 : m_sizes[m_current];
+            }
+
+            // Незавершённая строка, если есть, тоже отбрасывается
+            void reset()
+            {
+                m_current = 0;
+                m_used = 0;
+                m_start = 0;
+                m_capacity = m_sizes.empty() ? 0 : m_sizes[0];
+            }
+
+            // Сколько байт арена держит за собой
+            std::size_t reserved() const
+            {
+                std::size_t total = 0;
+                for (std::size_t size : m_sizes)
+                    total += size;
+                return total;
+            }
+
+        private:
+            // Переносит начатую строку в следующий блок, где хватит места
+            void grow(std::size_t extra)
+            {
+                const std::size_t pending = m_used - m_start;
+                std::size_t next = m_blocks.empty() ? 0 : m_current + 1;
+                while (next < m_sizes.size() && m_sizes[next] < pending + extra)
+                    ++next;
+                if (next == m_sizes.size())
+                {
+                    std::size_t size = block_size;
+                    while (size < pending + extra)
+                        size *= 2;
+                    m_blocks.emplace_back(new char[size]);
+                    m_sizes.push_back(size);
+                }
+                if (pending > 0)
+                    std::memcpy(m_blocks[next].get(), m_blocks[m_current].get() + m_start, pending);
+                m_current = next;
+                m_start = 0;
+                m_used = pending;
+                m_capacity = m_sizes[next];
+            }
+
+            std::vector<std::unique_ptr<char[]>> m_blocks;
+            std::vector<std::size_t> m_sizes;
+            std::size_t m_current = 0;
+            std::size_t m_used = 0;
+            std::size_t m_start = 0;
+            std::size_t m_capacity = 0;
+        };
+
+        // Поток вывода прямо в арену; одно значение обрезается до limit
+        // символов, чтобы огромный операнд не съел память
+        class ArenaStreamBuf : public std::streambuf
+        {
+        public:
+            static const std::size_t value_limit = 4096;
+
+            void start(Arena *arena)
+            {
+                m_arena = arena;
+                m_size = 0;
+            }
+
+            const char *finish()
+            {
+                if (m_size > value_limit)
+                    m_arena->write("...", 3);
+                return m_arena->finish();
+            }
+
+        protected:
+            int_type overflow(int_type c) override
+            {
+                if (!traits_type::eq_int_type(c, traits_type::eof()))
+                {
+                    if (m_size < value_limit)
+                        m_arena->put(traits_type::to_char_type(c));
+                    ++m_size;
+                }
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char *data, std::streamsize count) override
+            {
+                const std::size_t size = static_cast<std::size_t>(count);
+                if (m_size < value_limit)
+                {
+                    const std::size_t room = value_limit - m_size;
+                    m_arena->write(data, size < room ? size : room);
+                }
+                m_size += size;
+                return count;
+            }
+
+        private:
+            Arena *m_arena = nullptr;
+            std::size_t m_size = 0;
+        };
+    } // namespace detail
+} // namespace guard
+
+// Запись об одном провале. Место и выражение — статические строки,
+// значения операндов и текст сообщения лежат в арене теста
+struct guard_failure_record
+{
+    guard_location loc;
+    const char *cond;    // текст условия или nullptr
+    const char *lhs;     // значение левого операнда или nullptr
+    const char *rhs;     // значение правого операнда или nullptr
+    const char *message; // произвольное сообщение (FAIL, исключения) или nullptr
+    const char *detail;  // дифф операндов (строки с '\t', каждая с '\n') или nullptr
+};
 
 // Вся среда проверки в одной структуре
 struct guard_check_env_t
 {
-std::string error_msg;
-unsigned long long assert_total = 0;
-unsigned long long assert_failed = 0;
+std::vector<guard_failure_record> failures;
+unsigned long long failures_suppressed = 0;
+guard::detail::Arena arena;
+guard::detail::ArenaStreamBuf value_buf;
+std::ostream value_stream{&value_buf};
 };
 
-// Глобальный (на процесс) экземпляр среды, реализованный через
-// статическую локальную переменную внутри inline-функции
+// Экземпляр среды на поток, реализованный через thread_local переменную
+// внутри inline-функции. Каждый поток параллельного раннера копит свои
+// ошибки и счётчики, не мешая соседям.
 inline guard_check_env_t &guard_check_env()
 {
-    static guard_check_env_t env;
+    static thread_local guard_check_env_t env;
     return env;
 }
 
-// Макросы-алиасы, чтобы старый код продолжал работать как раньше
-#define guard_check_error_msg (guard_check_env().error_msg)
+// Счётчики проверок потока. Отдельная структура без конструктора: доступ
+// к ней на месте каждой проверки обходится без ленивой инициализации
+// thread_local-объекта, которая иначе встраивалась бы в каждый CHECK
+struct guard_check_counters_t
+{
+unsigned long long assert_total;
+unsigned long long assert_failed;
+};
+
+inline guard_check_counters_t &guard_check_counters()
+{
+    static thread_local guard_check_counters_t counters;
+    return counters;
+}
+
+// Сколько записей о мягких провалах хранить на тест (0 — без ограничения);
+// остальные только считаются. Задаётся до запуска тестов
+inline std::size_t &guard_check_max_failures()
+{
+    static std::size_t limit = 100;
+    return limit;
+}
+
+// Очистка записей перед очередным тестом; память арены остаётся
+inline void guard_check_env_clear()
+{
+    guard_check_env_t &env = guard_check_env();
+    env.failures.clear();
+    env.failures_suppressed = 0;
+    env.arena.reset();
+}
+
+inline bool guard_check_env_failed()
+{
+    const guard_check_env_t &env = guard_check_env();
+    return !env.failures.empty() || env.failures_suppressed > 0;
+}
+
+// Можно ли добавить ещё одну запись; если нет — провал только считается.
+// Фатальный провал записывается всегда: он последний в тесте
+inline bool guard_check_env_reserve_record(bool fatal)
+{
+    guard_check_env_t &env = guard_check_env();
+    const std::size_t limit = guard_check_max_failures();
+    if (fatal || limit == 0 || env.failures.size() < limit)
+        return true;
+    ++env.failures_suppressed;
+    return false;
+}
 
-// Начало "окружения" проверки: очищаем строку и запускаем try-блок
+// Снимок записей и счётчиков потока. Пробные прогоны кода с проверками
+// (поиск контрпримера в PROPERTY) откатываются к нему, не оставляя в
+// отчёте ни записей, ни строк в арене
+struct guard_check_env_mark
+{
+    std::size_t failures;
+    unsigned long long failures_suppressed;
+    guard::detail::Arena::Mark arena;
+    guard_check_counters_t counters;
+};
+
+inline guard_check_env_mark guard_check_env_save()
+{
+    const guard_check_env_t &env = guard_check_env();
+    guard_check_env_mark mark = {
+        env.failures.size(), env.failures_suppressed, env.arena.mark(), guard_check_counters()};
+    return mark;
+}
+
+// Были ли провалы после снимка
+inline bool guard_check_env_failed_since(const guard_check_env_mark &mark)
+{
+    const guard_check_env_t &env = guard_check_env();
+    return env.failures.size() > mark.failures ||
+           env.failures_suppressed > mark.failures_suppressed;
+}
+
+inline void guard_check_env_restore(const guard_check_env_mark &mark)
+{
+    guard_check_env_t &env = guard_check_env();
+    env.failures.resize(mark.failures);
+    env.failures_suppressed = mark.failures_suppressed;
+    env.arena.rewind(mark.arena);
+    guard_check_counters() = mark.counters;
+}
+
+// Начало "окружения" проверки: очищаем записи и запускаем try-блок
 #define GUARD_CHECK_ENV_START()                                                \
-    if (guard_check_error_msg.clear(), true)                                   \
+    if (guard_check_env_clear(), true)                                         \
         try
 
 // Ветка обработки ошибки (после выброса guard_check_exception)
 #define GUARD_CHECK_ENV_ERROR_HANDLER() catch (const guard_check_exception &)
 
-// Установка сообщения об ошибке (перезаписывает предыдущий текст)
+// Добавление сообщения об ошибке (для "мягких" CHECK)
+inline void GUARD_CHECK_ENV_APPEND(const std::string &msg)
+{
+    guard_check_env_t &env = guard_check_env();
+    guard_failure_record record = {};
+    record.message = env.arena.copy(msg);
+    env.failures.push_back(record);
+}
+
+// Установка сообщения об ошибке (перезаписывает предыдущие записи)
 inline void GUARD_CHECK_ENV_RAISE_SET(const std::string &msg)
 {
-    guard_check_error_msg = msg;
+    guard_check_env_clear();
+    GUARD_CHECK_ENV_APPEND(msg);
 }
 
 // Переход назад в точку GUARD_CHECK_ENV_START()
@@ -46,22 +333,58 @@ public:
         return "guard test failure";
     }
 };
-inline void GUARD_CHECK_ENV_RAISE_IMPL()
+[[noreturn]] inline void GUARD_CHECK_ENV_RAISE_IMPL()
 {
     throw guard_check_exception{};
 }
 inline void GUARD_CHECK_ENV_COUNT_ASSERT(bool success)
 {
-guard_check_env_t &env = guard_check_env();
-++env.assert_total;
+guard_check_counters_t &counters = guard_check_counters();
+++counters.assert_total;
 if (!success)
-    ++env.assert_failed;
+    ++counters.assert_failed;
 }
 
-// Добавление сообщения об ошибке (для "мягких" CHECK)
-inline void GUARD_CHECK_ENV_APPEND(const std::string &msg)
+// Сразу несколько проверок: поэлементные проверки диапазонов считают
+// каждый элемент, но обновляют счётчики один раз
+inline void GUARD_CHECK_ENV_COUNT_ASSERTS(unsigned long long total, unsigned long long failed)
+{
+guard_check_counters_t &counters = guard_check_counters();
+counters.assert_total += total;
+counters.assert_failed += failed;
+}
+
+// Текст всех записей текущего теста в формате отчёта; вызывается
+// раннером один раз после теста, а не при каждом провале
+inline std::string guard_check_env_render()
 {
-    if (!guard_check_error_msg.empty())
-        guard_check_error_msg.push_back('\n');
-    guard_check_error_msg += msg;
+    const guard_check_env_t &env = guard_check_env();
+    std::ostringstream os;
+    for (std::size_t i = 0; i < env.failures.size(); ++i)
+    {
+        const guard_failure_record &r = env.failures[i];
+        if (i > 0)
+            os << "\n";
+        if (r.message)
+        {
+            os << r.message;
+            continue;
+        }
+        os << "Error checked in location \n"
+           << "\tline:" << r.loc.line << "\n"
+           << "\tfile:" << r.loc.file << "\n"
+           << "\tfunc:" << r.loc.func << "\n"
+           << "\tcond:" << r.cond << "\n";
+        if (r.lhs)
+            os << "\tleft: " << r.lhs << "\n";
+        if (r.rhs)
+            os << "\tright: " << r.rhs << "\n";
+        else
+            os << "\f";
+        if (r.detail)
+            os << "\tdiff:\n" << r.detail;
+    }
+    if (env.failures_suppressed > 0)
+        os << "\n... " << env.failures_suppressed << " more failures suppressed\n";
+    return os.str();
 }
@@ -1,7 +1,45 @@
 #define GUARD_TEST_ENABLE_COLORS
 #include "check.h"
 #include "guard_main.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace gen = guard::prop::gen;
+
+// Итог проверок внутри f, не попавший в отчёт: был ли провал и тексты
+// всех его записей (сообщения, операнды, дифф)
+struct QuietResult
+{
+    bool failed;
+    std::string text;
+};
+
+template <typename F>
+static QuietResult quietly(F f)
+{
+    const guard_check_env_mark mark = guard_check_env_save();
+    f();
+    QuietResult result = {guard_check_env_failed_since(mark), std::string()};
+    const guard_check_env_t &env = guard_check_env();
+    for (std::size_t i = mark.failures; i < env.failures.size(); ++i)
+    {
+        const guard_failure_record &r = env.failures[i];
+        const char *const parts[] = {r.message, r.lhs, r.rhs, r.detail};
+        for (const char *part : parts)
+        {
+            if (part)
+                result.text.append(part).append("\n");
+        }
+    }
+    guard_check_env_restore(mark);
+    return result;
+}
 
 TEST_CASE("simple arithmetic")
 {
@@ -39,4 +77,173 @@ TEST_CASE("failed test: simple arithmetic")
     CHECK_LT(20, 10);
 }
 
+// Уменьшение контрпримера доходит до границы нарушения при любом зерне
+static void below_1000(const int &x)
+{
+    CHECK_LT(x, 1000);
+}
+
+static void sum_below_500(const int &a, const int &b)
+{
+    CHECK_LT(a + b, 500);
+}
+
+TEST_CASE("property counterexamples shrink to the boundary")
+{
+    const QuietResult one = quietly([] {
+        guard::prop::check("x < 1000", std::make_tuple(gen::integers<int>()), &below_1000);
+    });
+    CHECK(one.failed);
+    CHECK(one.text.find("args: (1000)") != std::string::npos);
+
+    const QuietResult two = quietly([] {
+        guard::prop::check("a + b < 500",
+                           std::make_tuple(gen::integers<int>(-1000, 1000), gen::integers<int>(-1000, 1000)),
+                           &sum_below_500);
+    });
+    CHECK(two.failed);
+    CHECK(two.text.find("args: (500, 0)") != std::string::npos);
+}
+
+PROPERTY("sorting keeps the size", gen::vectors(gen::integers<int>(-1000, 1000)))
+(const std::vector<int> &v)
+{
+    std::vector<int> sorted = v;
+    std::sort(sorted.begin(), sorted.end());
+    CHECK_EQ(sorted.size(), v.size());
+}
+
+TEST_CASE("CHECK_ALL_ULP: signed zeros, NaN and tail elements")
+{
+    const std::vector<double> zeros = {0.0, -0.0, 0.0, -0.0, 0.0};
+    const std::vector<double> flipped = {-0.0, 0.0, 0.0, -0.0, -0.0};
+    CHECK_ALL_ULP(zeros, flipped, 0);
+
+    // NaN не совпадает ни с чем, даже сам с собой
+    std::vector<double> nan(9, 1.0);
+    nan[8] = std::numeric_limits<double>::quiet_NaN();
+    CHECK(quietly([&] { CHECK_ALL_ULP(nan, nan, 1000); }).failed);
+
+    // 7 элементов: отличие только в хвосте после векторной части
+    const std::vector<float> a(7, 1.0f);
+    std::vector<float> b = a;
+    b[6] = std::nextafter(1.0f, 2.0f);
+    CHECK_ALL_ULP(a, b, 1);
+    const QuietResult tail = quietly([&] { CHECK_ALL_ULP(a, b, 0); });
+    CHECK(tail.failed);
+    CHECK(tail.text.find("1 of 7 elements differ") != std::string::npos);
+}
+
+// Особые значения для сравнения векторного цикла CHECK_ALL_ULP со
+// скалярной формулой
+static const double ulp_specials[] = {
+    0.0,
+    -0.0,
+    1.0,
+    -1.0,
+    std::numeric_limits<double>::denorm_min(),
+    -std::numeric_limits<double>::denorm_min(),
+    std::numeric_limits<double>::max(),
+    std::numeric_limits<double>::lowest(),
+    std::numeric_limits<double>::infinity(),
+    -std::numeric_limits<double>::infinity(),
+    std::numeric_limits<double>::quiet_NaN(),
+    1e-300,
+};
+
+// Векторный цикл и скалярная формула дают один ответ на любой длине,
+// в том числе с хвостом короче вектора; b[i] — a[i], сдвинутое на
+// steps[i] представимых чисел
+template <typename T>
+static void ulp_paths_agree(const std::vector<unsigned> &picks, const std::vector<int> &steps,
+                            unsigned max_ulps)
+{
+    typedef typename guard::bulk::detail::UlpTraits<T>::Bits Bits;
+    std::vector<T> a;
+    std::vector<T> b;
+    bool scalar_bad = false;
+    for (std::size_t i = 0; i < picks.size(); ++i)
+    {
+        const T x = static_cast<T>(ulp_specials[picks[i]]);
+        const int step = steps.empty() ? 0 : steps[i % steps.size()];
+        T y = x;
+        for (int k = 0; k < (step < 0 ? -step : step); ++k)
+            y = std::nextafter(y, step < 0 ? -std::numeric_limits<T>::infinity()
+                                           : std::numeric_limits<T>::infinity());
+        a.push_back(x);
+        b.push_back(y);
+        scalar_bad = scalar_bad || !guard::bulk::detail::ulp_ok(x, y, static_cast<Bits>(max_ulps));
+    }
+    CHECK_EQ(guard::bulk::detail::any_bad_ulp(a.data(), b.data(), a.size(), static_cast<Bits>(max_ulps)),
+             scalar_bad);
+}
+
+PROPERTY("CHECK_ALL_ULP: SIMD loop agrees with the scalar formula",
+         gen::vectors(gen::integers<unsigned>(0, sizeof(ulp_specials) / sizeof(ulp_specials[0]) - 1)),
+         gen::vectors(gen::integers<int>(-3, 3), 1, 8),
+         gen::integers<unsigned>(0, 4))
+(const std::vector<unsigned> &picks, const std::vector<int> &steps, const unsigned &max_ulps)
+{
+    ulp_paths_agree<double>(picks, steps, max_ulps);
+    ulp_paths_agree<float>(picks, steps, max_ulps);
+}
+
+// Длинные строки в провале CHECK_EQ сравниваются диффом: по строкам
+// (unified diff) или, без переводов строк, по байтам
+TEST_CASE("CHECK_EQ on long strings prints a diff")
+{
+    std::string expected;
+    for (int i = 0; i < 100; ++i)
+        expected += "line " + std::to_string(i) + "\n";
+    std::string actual = expected;
+    actual.replace(actual.find("line 50\n"), 8, "line fifty\n");
+
+    const QuietResult lines = quietly([&] { CHECK_EQ(actual, expected); });
+    CHECK(lines.failed);
+    CHECK(lines.text.find("@@ -48,7 +48,7 @@") != std::string::npos);
+    CHECK(lines.text.find("\t-line fifty\n\t+line 50\n") != std::string::npos);
+    CHECK(lines.text.find("line 10\n") == std::string::npos);
+
+    const std::string row(200, 'x');
+    std::string changed = row;
+    changed[150] = 'y';
+    const QuietResult bytes = quietly([&] { CHECK_EQ(changed, row); });
+    CHECK(bytes.failed);
+    CHECK(bytes.text.find("@@ byte 150 @@") != std::string::npos);
+    CHECK(bytes.text.find("[-y-]{+x+}") != std::string::npos);
+
+    // Короткие строки печатаются целиком, без диффа
+    const QuietResult plain = quietly([] { CHECK_EQ(std::string("abc"), std::string("abd")); });
+    CHECK(plain.failed);
+    CHECK(plain.text.find("@@") == std::string::npos);
+}
+
+// Запускается с --benchmark
+BENCHMARK("accumulate 1k ints")
+{
+    std::vector<int> data(1000, 1);
+    state.set_items_per_iteration(1000);
+    while (state.keep_running())
+        guard::do_not_optimize(std::accumulate(data.begin(), data.end(), 0));
+}
+
+// Стоимость одной проходящей проверки на больших операндах
+BENCHMARK("CHECK_EQ on 64 KiB strings")
+{
+    const std::string lhs(64 * 1024, 'x');
+    const std::string rhs = lhs;
+    state.set_bytes_per_iteration(lhs.size());
+    while (state.keep_running())
+        CHECK_EQ(lhs, rhs);
+}
+
+BENCHMARK("CHECK_EQ on 16k-int vectors")
+{
+    const std::vector<int> lhs(16 * 1024, 7);
+    const std::vector<int> rhs = lhs;
+    state.set_bytes_per_iteration(lhs.size() * sizeof(int));
+    while (state.keep_running())
+        CHECK_EQ(lhs, rhs);
+}
+
 GUARD_TEST_MAIN();
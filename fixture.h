@@ -0,0 +1,145 @@
+// guard/fixture.h
+#pragma once
+
+#include "alloc.h"
+#include "macro.h"
+#include "registry.h"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Общие фикстуры: GUARD_SHARED_FIXTURE(BigIndex, index);
+//
+// Объект строится при первом обращении (index->find(...), *index) одним
+// потоком, остальные ждут готовности; дальше все тесты и потоки раннера
+// читают его через const-ссылку. Уничтожается при выходе из программы.
+// Затраты построения учитываются отдельно: время, CPU, rusage и
+// аппаратные счётчики вычитаются из замеров теста, который его
+// дождался, выделения памяти не считаются вовсе, а время построения
+// печатается в сводке прогона. Если
+// конструктор бросил исключение, построение не повторяется — каждый
+// тест, обратившийся к фикстуре, проваливается с тем же сообщением.
+
+namespace guard
+{
+    namespace fixture
+    {
+        // Узел списка shared(): имя, место объявления и итог построения
+        struct Shared
+        {
+            const char *name;
+            const char *file;
+            int line;
+            // Время построения, мкс; заполняется вместе с built
+            double setup_us;
+            // Текст исключения конструктора (пусто — построен)
+            std::string error;
+            std::atomic<bool> built;
+            Shared *next;
+        };
+
+        inline guard::detail::IntrusiveList<Shared> &shared()
+        {
+            static guard::detail::IntrusiveList<Shared> instance;
+            return instance;
+        }
+
+        // Замер затрат построения: раннер ставит функции, которые в
+        // begin() снимают счётчики потока (время, CPU, rusage, perf), а в
+        // end() копят разницу, чтобы вычесть её из теста. Вызовы парные и
+        // охватывают и ожидание фикстуры, которую строит другой поток
+        struct SetupMeter
+        {
+            void (*begin)();
+            void (*end)();
+        };
+
+        inline SetupMeter &setup_meter()
+        {
+            static SetupMeter meter = {nullptr, nullptr};
+            return meter;
+        }
+
+        template <typename T>
+        class SharedFixture
+        {
+        public:
+            SharedFixture(const char *name, const char *file, int line)
+            {
+                m_node.name = name;
+                m_node.file = file;
+                m_node.line = line;
+                m_node.setup_us = 0;
+                m_node.built.store(false, std::memory_order_relaxed);
+                m_node.next = nullptr;
+                shared().push_back(&m_node);
+            }
+
+            SharedFixture(const SharedFixture &) = delete;
+            SharedFixture &operator=(const SharedFixture &) = delete;
+
+            const T &get()
+            {
+                if (!m_node.built.load(std::memory_order_acquire))
+                    build();
+                if (!m_value)
+                    throw std::runtime_error(std::string("shared fixture \"") + m_node.name +
+                                             "\" setup failed: " + m_node.error);
+                return *m_value;
+            }
+
+            const T &operator*()
+            {
+                return get();
+            }
+
+            const T *operator->()
+            {
+                return &get();
+            }
+
+        private:
+            // Выделения памяти при построении не учитываются
+            // (guard::alloc::Suspend): фикстура не принадлежит тесту
+            GUARD_COLD void build()
+            {
+                const SetupMeter meter = setup_meter();
+                if (meter.begin)
+                    meter.begin();
+                {
+                    guard::alloc::Suspend suspend;
+                    std::call_once(m_once, [this]() {
+                        const auto start = std::chrono::steady_clock::now();
+                        try
+                        {
+                            m_value.reset(new T());
+                        }
+                        catch (const std::exception &ex)
+                        {
+                            m_node.error = ex.what();
+                        }
+                        catch (...)
+                        {
+                            m_node.error = "non-std exception";
+                        }
+                        m_node.setup_us = std::chrono::duration<double, std::micro>(
+                                              std::chrono::steady_clock::now() - start)
+                                              .count();
+                        m_node.built.store(true, std::memory_order_release);
+                    });
+                }
+                if (meter.end)
+                    meter.end();
+            }
+
+            std::once_flag m_once;
+            std::unique_ptr<T> m_value;
+            Shared m_node;
+        };
+    } // namespace fixture
+} // namespace guard
@@ -0,0 +1,287 @@
+// guard/fuzz.h
+#pragma once
+
+#include "env.h"
+#include "registry.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if !defined(GUARD_TEST_CORPUS_SUPPORTED)
+#if defined(__unix__) || defined(__APPLE__)
+#define GUARD_TEST_CORPUS_SUPPORTED 1
+#else
+#define GUARD_TEST_CORPUS_SUPPORTED 0
+#endif
+#endif
+
+#if GUARD_TEST_CORPUS_SUPPORTED
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Цели фаззинга: FUZZ_TEST("name", const std::uint8_t *data, std::size_t size) { ... }
+//
+// В обычном прогоне цель — тест с меткой [fuzz]: тело вызывается на
+// пустом входе и на каждом файле каталога корпуса <--fuzz-corpus>/<имя>,
+// провал помечается файлом, на котором он случился. Со сборкой
+// -fsanitize=fuzzer -DGUARD_TEST_FUZZING GUARD_TEST_MAIN() вместо main
+// определяет LLVMFuzzerTestOneInput: те же CHECK/REQUIRE превращаются в
+// abort(), который libFuzzer сохраняет как crash-файл. Такой файл,
+// положенный в каталог корпуса, становится регрессионным входом.
+
+namespace guard
+{
+    namespace fuzz
+    {
+        using FuzzFunc = void (*)(const std::uint8_t *data, std::size_t size);
+
+        struct Target
+        {
+            const char *name;
+            const char *file;
+            int line;
+            FuzzFunc func;
+            // Следующая цель (узел списка targets())
+            Target *next;
+        };
+
+        inline guard::detail::IntrusiveList<Target> &targets()
+        {
+            static guard::detail::IntrusiveList<Target> instance;
+            return instance;
+        }
+
+        struct Registrar
+        {
+            Registrar(const char *file, int line, FuzzFunc func, const char *name)
+                : node{name, file, line, func, nullptr}
+            {
+                targets().push_back(&node);
+            }
+
+            Registrar(const Registrar &) = delete;
+            Registrar &operator=(const Registrar &) = delete;
+
+            Target node;
+        };
+
+        // Корень корпусов (--fuzz-corpus); корпус цели — подкаталог с
+        // именем цели, где всё, кроме букв, цифр, '-' и '.', заменено на '_'
+        inline std::string &corpus_root()
+        {
+            static std::string root = "fuzz_corpus";
+            return root;
+        }
+
+        inline std::string corpus_dir(const char *name)
+        {
+            std::string dir = corpus_root();
+            if (!dir.empty() && dir.back() != '/')
+                dir += '/';
+            for (const char *c = name; *c; ++c)
+            {
+                const bool keep = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+                                  (*c >= '0' && *c <= '9') || *c == '-' || *c == '.';
+                dir += keep ? *c : '_';
+            }
+            return dir;
+        }
+
+        namespace detail
+        {
+            // Файлы каталога в порядке имён (скрытые пропускаются);
+            // пусто, если каталога нет
+            inline std::vector<std::string> list_files(const std::string &dir)
+            {
+                std::vector<std::string> files;
+#if GUARD_TEST_CORPUS_SUPPORTED
+                DIR *handle = ::opendir(dir.c_str());
+                if (!handle)
+                    return files;
+                while (const struct dirent *entry = ::readdir(handle))
+                {
+                    if (entry->d_name[0] == '.')
+                        continue;
+                    std::string path = dir + '/' + entry->d_name;
+                    struct stat info;
+                    if (::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+                        files.push_back(std::move(path));
+                }
+                ::closedir(handle);
+                std::sort(files.begin(), files.end());
+#else
+                (void)dir;
+#endif
+                return files;
+            }
+
+            // Содержимое файла в data (буфер переиспользуется)
+            inline bool read_file(const std::string &path, std::vector<std::uint8_t> &data)
+            {
+                data.clear();
+                std::FILE *file = std::fopen(path.c_str(), "rb");
+                if (!file)
+                    return false;
+                std::uint8_t chunk[4096];
+                std::size_t got;
+                while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+                    data.insert(data.end(), chunk, chunk + got);
+                const bool ok = !std::ferror(file);
+                std::fclose(file);
+                return ok;
+            }
+
+            // Записи о провалах входа идут после строки с его именем
+            inline void label_failures(const guard_check_env_mark &mark, const std::string &label)
+            {
+                GUARD_CHECK_ENV_APPEND(label);
+                std::vector<guard_failure_record> &failures = guard_check_env().failures;
+                if (failures.size() > mark.failures + 1)
+                    std::rotate(failures.begin() + static_cast<std::ptrdiff_t>(mark.failures),
+                                failures.end() - 1,
+                                failures.end());
+            }
+
+            inline std::string input_label(const std::string &input, std::size_t size)
+            {
+                return "Fuzz input " + input + " (" + std::to_string(size) +
+                       (size == 1 ? " byte)" : " bytes)");
+            }
+
+            // Один вход в обычном прогоне. REQUIRE завершает тест как
+            // обычно, исключение тела засчитывается провалом входа
+            inline void replay_input(const Target &target, const std::string &input,
+                                     const std::uint8_t *data, std::size_t size)
+            {
+                const guard_check_env_mark mark = guard_check_env_save();
+                try
+                {
+                    target.func(data, size);
+                }
+                catch (const guard_check_exception &)
+                {
+                    label_failures(mark, input_label(input, size));
+                    throw;
+                }
+                catch (const std::exception &ex)
+                {
+                    GUARD_CHECK_ENV_COUNT_ASSERT(false);
+                    GUARD_CHECK_ENV_APPEND(std::string("\tthrows std::exception: ") + ex.what());
+                }
+                catch (...)
+                {
+                    GUARD_CHECK_ENV_COUNT_ASSERT(false);
+                    GUARD_CHECK_ENV_APPEND("\tthrows a non-std exception");
+                }
+                if (guard_check_env_failed_since(mark))
+                    label_failures(mark, input_label(input, size));
+            }
+        } // namespace detail
+
+        // Тело теста FUZZ_TEST: пустой вход и весь корпус цели
+        inline void replay(const Target &target)
+        {
+            detail::replay_input(target, "<empty>", nullptr, 0);
+            std::vector<std::uint8_t> data;
+            for (const std::string &path : detail::list_files(corpus_dir(target.name)))
+            {
+                if (!detail::read_file(path, data))
+                {
+                    GUARD_CHECK_ENV_COUNT_ASSERT(false);
+                    GUARD_CHECK_ENV_APPEND("Fuzz input " + path + " can't be read");
+                    continue;
+                }
+                detail::replay_input(target, path, data.empty() ? nullptr : data.data(), data.size());
+            }
+        }
+
+        namespace detail
+        {
+            inline const Target *&selected()
+            {
+                static const Target *target = nullptr;
+                return target;
+            }
+
+            inline void print_targets(std::FILE *out)
+            {
+                for (const Target &t : targets())
+                    std::fprintf(out, "  %s (%s:%d)\n", t.name, t.file, t.line);
+            }
+        } // namespace detail
+
+        // LLVMFuzzerInitialize: выбор цели по --fuzz-target=NAME (libFuzzer
+        // пропускает флаги с "--") или переменной GUARD_FUZZ_TARGET;
+        // единственную цель можно не называть
+        inline int initialize(int *argc, char ***argv)
+        {
+            const char *name = std::getenv("GUARD_FUZZ_TARGET");
+            static const char flag[] = "--fuzz-target=";
+            for (int i = 1; argc && argv && i < *argc; ++i)
+            {
+                if (std::strncmp((*argv)[i], flag, sizeof(flag) - 1) == 0)
+                    name = (*argv)[i] + sizeof(flag) - 1;
+            }
+
+            const Target *found = nullptr;
+            for (const Target &t : targets())
+            {
+                if (name ? std::strcmp(t.name, name) == 0 : targets().size() == 1)
+                    found = &t;
+            }
+            if (!found)
+            {
+                if (name)
+                    std::fprintf(stderr, "guard: no FUZZ_TEST named \"%s\"; targets:\n", name);
+                else
+                    std::fprintf(stderr, "guard: choose a target with --fuzz-target=NAME or "
+                                         "GUARD_FUZZ_TARGET; targets:\n");
+                detail::print_targets(stderr);
+                std::exit(1);
+            }
+            detail::selected() = found;
+            return 0;
+        }
+
+        // LLVMFuzzerTestOneInput: любой провал проверки печатается и
+        // завершает процесс через abort(), исключения уходят в libFuzzer
+        inline int test_one_input(const std::uint8_t *data, std::size_t size)
+        {
+            const Target *target = detail::selected();
+            if (!target)
+            {
+                initialize(nullptr, nullptr);
+                target = detail::selected();
+            }
+            guard_check_env_clear();
+            try
+            {
+                target->func(data, size);
+            }
+            catch (const guard_check_exception &)
+            {
+            }
+            if (guard_check_env_failed())
+            {
+                std::fprintf(stderr,
+                             "guard: FUZZ_TEST \"%s\" (%s:%d) failed on %zu-byte input\n%s\n",
+                             target->name,
+                             target->file,
+                             target->line,
+                             size,
+                             guard_check_env_render().c_str());
+                std::abort();
+            }
+            return 0;
+        }
+    } // namespace fuzz
+} // namespace guard
@@ -6,10 +6,41 @@
 #include <stdio.h>
 #include <string.h>
 
+/*
+ * Подсчёт выделений памяти: определите GUARD_C_ALLOC_HOOKS до подключения
+ * guard_c.h в файле с тестами. Тогда этот файл подменяет malloc/free и
+ * родственные функции поверх __libc_* (только glibc, только C), и для
+ * каждого теста считаются число выделений, байты и пик живой памяти — все
+ * в запрошенных байтах.
+ */
+#if defined(GUARD_C_ALLOC_HOOKS)
+#if defined(__cplusplus)
+#error "GUARD_C_ALLOC_HOOKS is for C sources; define GUARD_TEST_ALLOC_HOOKS in C++"
+#endif
+#if !defined(__GLIBC__)
+#error "GUARD_C_ALLOC_HOOKS requires glibc"
+#endif
+#include <errno.h>
+#include <malloc.h>
+#include <unistd.h>
+#define GUARD_C_ALLOC_TRACKING 1
+#else
+#define GUARD_C_ALLOC_TRACKING 0
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Счётчики выделений текущего потока */
+typedef struct guard_c_alloc_counters
+{
+    unsigned long count;
+    unsigned long bytes;
+    long live;
+    long peak;
+} guard_c_alloc_counters;
+
 typedef int (*guard_c_test_func)(void);
 
 typedef struct guard_c_state
@@ -28,6 +59,8 @@ typedef struct guard_c_state
     int current_failed;
     int current_asserts;
     int current_failed_asserts;
+    unsigned long allocs_total;
+    unsigned long alloc_bytes_total;
 } guard_c_state;
 
 static guard_c_state* guard_c_get_state(void)
@@ -36,6 +69,204 @@ static guard_c_state* guard_c_get_state(void)
     return &state;
 }
 
+static guard_c_alloc_counters* guard_c_alloc_get_counters(void)
+{
+#if GUARD_C_ALLOC_TRACKING
+    static __thread guard_c_alloc_counters counters;
+#else
+    static guard_c_alloc_counters counters;
+#endif
+    return &counters;
+}
+
+#if GUARD_C_ALLOC_TRACKING
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t align, size_t size);
+extern void __libc_free(void* ptr);
+
+/*
+ * Перед каждым блоком лежит заголовок с запрошенным размером и смещением
+ * от начала блока __libc_*, как в alloc.h: живая память и пик считаются
+ * в запрошенных байтах, а не в округлённых malloc_usable_size.
+ */
+typedef struct guard_c_alloc_header
+{
+    size_t size;
+    size_t offset;
+} guard_c_alloc_header;
+
+/* Выравнивание malloc в glibc на 64-битных платформах и i386 */
+#define GUARD_C_ALLOC_ALIGN ((size_t)16)
+
+static guard_c_alloc_header* guard_c_alloc_header_of(void* ptr)
+{
+    return (guard_c_alloc_header*)ptr - 1;
+}
+
+/* base — блок __libc_* размером prefix + size; NULL проходит насквозь */
+static void* guard_c_alloc_note(char* base, size_t prefix, size_t size)
+{
+    guard_c_alloc_counters* c = guard_c_alloc_get_counters();
+    guard_c_alloc_header* h;
+    if (base == NULL)
+    {
+        return NULL;
+    }
+    h = guard_c_alloc_header_of(base + prefix);
+    h->size = size;
+    h->offset = prefix;
+    ++c->count;
+    c->bytes += (unsigned long)size;
+    c->live += (long)size;
+    if (c->live > c->peak)
+    {
+        c->peak = c->live;
+    }
+    return base + prefix;
+}
+
+static int guard_c_alloc_too_big(size_t prefix, size_t size)
+{
+    if (size > (size_t)-1 - prefix)
+    {
+        errno = ENOMEM;
+        return 1;
+    }
+    return 0;
+}
+
+void* malloc(size_t size)
+{
+    if (guard_c_alloc_too_big(GUARD_C_ALLOC_ALIGN, size))
+    {
+        return NULL;
+    }
+    return guard_c_alloc_note((char*)__libc_malloc(GUARD_C_ALLOC_ALIGN + size), GUARD_C_ALLOC_ALIGN, size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if (size != 0 && count > (size_t)-1 / size)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (guard_c_alloc_too_big(GUARD_C_ALLOC_ALIGN, count * size))
+    {
+        return NULL;
+    }
+    return guard_c_alloc_note((char*)__libc_calloc(1, GUARD_C_ALLOC_ALIGN + count * size), GUARD_C_ALLOC_ALIGN, count * size);
+}
+
+void* memalign(size_t align, size_t size)
+{
+    /* Заголовок занимает целое число шагов выравнивания перед блоком */
+    const size_t prefix = align > GUARD_C_ALLOC_ALIGN ? align : GUARD_C_ALLOC_ALIGN;
+    if (guard_c_alloc_too_big(prefix, size))
+    {
+        return NULL;
+    }
+    return guard_c_alloc_note((char*)__libc_memalign(prefix, prefix + size), prefix, size);
+}
+
+void free(void* ptr)
+{
+    guard_c_alloc_header* h;
+    if (ptr == NULL)
+    {
+        return;
+    }
+    h = guard_c_alloc_header_of(ptr);
+    guard_c_alloc_get_counters()->live -= (long)h->size;
+    __libc_free((char*)ptr - h->offset);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    guard_c_alloc_header* h;
+    size_t old_size;
+    char* base;
+    if (ptr == NULL)
+    {
+        return malloc(size);
+    }
+    /* realloc(ptr, 0) в glibc освобождает ptr и возвращает NULL */
+    if (size == 0)
+    {
+        free(ptr);
+        return NULL;
+    }
+    h = guard_c_alloc_header_of(ptr);
+    old_size = h->size;
+    if (h->offset != GUARD_C_ALLOC_ALIGN)
+    {
+        /* Блок memalign: __libc_realloc не сохранит выравнивание */
+        void* result = malloc(size);
+        if (result != NULL)
+        {
+            memcpy(result, ptr, old_size < size ? old_size : size);
+            free(ptr);
+        }
+        return result;
+    }
+    if (guard_c_alloc_too_big(GUARD_C_ALLOC_ALIGN, size))
+    {
+        return NULL;
+    }
+    base = (char*)__libc_realloc((char*)ptr - GUARD_C_ALLOC_ALIGN, GUARD_C_ALLOC_ALIGN + size);
+    if (base == NULL)
+    {
+        return NULL;
+    }
+    guard_c_alloc_get_counters()->live -= (long)old_size;
+    return guard_c_alloc_note(base, GUARD_C_ALLOC_ALIGN, size);
+}
+
+void* aligned_alloc(size_t align, size_t size)
+{
+    return memalign(align, size);
+}
+
+int posix_memalign(void** out, size_t align, size_t size)
+{
+    void* ptr;
+    if (align < sizeof(void*) || (align & (align - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    ptr = memalign(align, size);
+    if (ptr == NULL)
+    {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+/* Без этих подмен блоки из libc остались бы без заголовка */
+void* valloc(size_t size)
+{
+    return memalign((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+void* pvalloc(size_t size)
+{
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (guard_c_alloc_too_big(page, size))
+    {
+        return NULL;
+    }
+    return memalign(page, (size + page - 1) / page * page);
+}
+
+size_t malloc_usable_size(void* ptr)
+{
+    return ptr != NULL ? guard_c_alloc_header_of(ptr)->size : 0;
+}
+#endif
+
 static int guard_c_streq(const char* lhs, const char* rhs)
 {
     if (lhs == NULL || rhs == NULL)
@@ -128,6 +359,11 @@ static void guard_c_run(const char* name, guard_c_test_func func, const char* fi
 {
     guard_c_state* state = guard_c_get_state();
     FILE* out = state->out != NULL ? state->out : stdout;
+    guard_c_alloc_counters* allocs = guard_c_alloc_get_counters();
+    guard_c_alloc_counters start;
+    unsigned long alloc_count;
+    unsigned long alloc_bytes;
+    long alloc_peak;
     int rc;
 
     if (!guard_c_contains(name, state->filter))
@@ -148,29 +384,50 @@ static void guard_c_run(const char* name, guard_c_test_func func, const char* fi
         fprintf(out, "Running test: \"%s\" (%s:%d)\n", name, file, line);
     }
 
+    start = *allocs;
+    allocs->peak = allocs->live;
     rc = func();
     if (rc != 0)
     {
         state->current_failed = 1;
     }
+    alloc_count = allocs->count - start.count;
+    alloc_bytes = allocs->bytes - start.bytes;
+    alloc_peak = allocs->peak - start.live;
+    if (start.peak > allocs->peak)
+    {
+        allocs->peak = start.peak;
+    }
+    state->allocs_total += alloc_count;
+    state->alloc_bytes_total += alloc_bytes;
 
     if (state->current_failed)
     {
         ++state->tests_failed;
         fprintf(out,
-                "[FAIL] %s (%s:%d, asserts %d, failed %d)\n",
+                "[FAIL] %s (%s:%d, asserts %d, failed %d",
                 name,
                 file,
                 line,
                 state->current_asserts,
                 state->current_failed_asserts);
+        if (GUARD_C_ALLOC_TRACKING)
+        {
+            fprintf(out, ", allocs %lu, bytes %lu, peak %ld", alloc_count, alloc_bytes, alloc_peak > 0 ? alloc_peak : 0);
+        }
+        fprintf(out, ")\n");
     }
     else
     {
         ++state->tests_passed;
         if (state->verbose)
         {
-            fprintf(out, "[ OK ] %s (%d asserts)\n", name, state->current_asserts);
+            fprintf(out, "[ OK ] %s (%d asserts", name, state->current_asserts);
+            if (GUARD_C_ALLOC_TRACKING)
+            {
+                fprintf(out, ", allocs %lu, bytes %lu, peak %ld", alloc_count, alloc_bytes, alloc_peak > 0 ? alloc_peak : 0);
+            }
+            fprintf(out, ")\n");
         }
     }
 
@@ -195,6 +452,10 @@ static int guard_c_end(void)
         fprintf(out, " (failed %d)", state->asserts_failed);
     }
     fprintf(out, "\n");
+    if (GUARD_C_ALLOC_TRACKING)
+    {
+        fprintf(out, "Allocs    : %lu (bytes %lu)\n", state->allocs_total, state->alloc_bytes_total);
+    }
     fprintf(out, "=======================\n");
 
     return state->tests_failed == 0 ? 0 : 1;
@@ -354,6 +615,31 @@ static int guard_c_end(void)
         guard_c_record_assert(guard_c_expected_ == guard_c_actual_, #expected_ " == " #actual_, __FILE__, __LINE__, __func__, guard_c_detail_); \
     } while (0)
 
+/* code_ делает не больше n_ выделений памяти; требует GUARD_C_ALLOC_HOOKS */
+#define GUARD_C_CHECK_MAX_ALLOCS(code_, n_)                                    \
+    do                                                                         \
+    {                                                                          \
+        const unsigned long guard_c_before_ = guard_c_alloc_get_counters()->count; \
+        const unsigned long guard_c_bytes_before_ = guard_c_alloc_get_counters()->bytes; \
+        unsigned long guard_c_allocs_;                                         \
+        unsigned long guard_c_bytes_;                                          \
+        char guard_c_detail_[160];                                             \
+        code_;                                                                 \
+        guard_c_allocs_ = guard_c_alloc_get_counters()->count - guard_c_before_; \
+        guard_c_bytes_ = guard_c_alloc_get_counters()->bytes - guard_c_bytes_before_; \
+        if (GUARD_C_ALLOC_TRACKING)                                            \
+        {                                                                      \
+            snprintf(guard_c_detail_, sizeof(guard_c_detail_), "allocs: %lu (bytes %lu), limit: %lu", guard_c_allocs_, guard_c_bytes_, (unsigned long)(n_)); \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            snprintf(guard_c_detail_, sizeof(guard_c_detail_), "allocation tracking is disabled, define GUARD_C_ALLOC_HOOKS"); \
+        }                                                                      \
+        guard_c_record_assert(GUARD_C_ALLOC_TRACKING && guard_c_allocs_ <= (unsigned long)(n_), "allocs(" #code_ ") <= " #n_, __FILE__, __LINE__, __func__, guard_c_detail_); \
+    } while (0)
+
+#define GUARD_C_CHECK_NO_ALLOC(code_) GUARD_C_CHECK_MAX_ALLOCS(code_, 0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,19 +1,67 @@
 // guard.h (или guard/test.h)
 #pragma once
 
+#include "alloc.h"
+#include "bench.h"
+#include "bulk.h"
+#include "capture.h"
 #include "check.h"
 #include "env.h"
+#include "fixture.h"
+#include "fuzz.h"
+#include "perf.h"
+#include "property.h"
+#include "range.h"
+#include "registry.h"
+#include "reporter.h"
+#include "select.h"
 #include "util.h"
 #include <algorithm>
+#include <atomic>
 #include <map>
+#include <memory>
 
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <deque>
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#if !defined(GUARD_TEST_FORK_SUPPORTED)
+#if defined(__unix__) || defined(__APPLE__)
+#define GUARD_TEST_FORK_SUPPORTED 1
+#else
+#define GUARD_TEST_FORK_SUPPORTED 0
+#endif
+#endif
+
+#if GUARD_TEST_FORK_SUPPORTED
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 namespace guard
 {
 namespace detail
@@ -69,6 +117,80 @@ namespace detail
         os << value;
         return os.str();
     }
+
+    // Процессорное время текущего потока в микросекундах. Там, где нет
+    // CLOCK_THREAD_CPUTIME_ID, используется время всего процесса.
+    inline double thread_cpu_us()
+    {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+            return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#endif
+        return static_cast<double>(std::clock()) * 1e6 / CLOCKS_PER_SEC;
+    }
+
+    // Ресурсы, израсходованные потоком: процессорное время в режимах
+    // пользователя и ядра, переключения контекста (добровольные — ожидание
+    // ввода-вывода и блокировок, вынужденные — вытеснение планировщиком)
+    // и страничные ошибки (без обращения к диску и с ним)
+    struct ResourceUsage
+    {
+        double user_us = 0;
+        double sys_us = 0;
+        std::uint64_t voluntary_switches = 0;
+        std::uint64_t involuntary_switches = 0;
+        std::uint64_t minor_faults = 0;
+        std::uint64_t major_faults = 0;
+
+        ResourceUsage &operator+=(const ResourceUsage &other)
+        {
+            user_us += other.user_us;
+            sys_us += other.sys_us;
+            voluntary_switches += other.voluntary_switches;
+            involuntary_switches += other.involuntary_switches;
+            minor_faults += other.minor_faults;
+            major_faults += other.major_faults;
+            return *this;
+        }
+
+        ResourceUsage operator-(const ResourceUsage &start) const
+        {
+            ResourceUsage d;
+            d.user_us = user_us - start.user_us;
+            d.sys_us = sys_us - start.sys_us;
+            d.voluntary_switches = voluntary_switches - start.voluntary_switches;
+            d.involuntary_switches = involuntary_switches - start.involuntary_switches;
+            d.minor_faults = minor_faults - start.minor_faults;
+            d.major_faults = major_faults - start.major_faults;
+            return d;
+        }
+    };
+
+    // getrusage(RUSAGE_THREAD) там, где он есть (Linux); на других POSIX —
+    // счётчики всего процесса, точные только при последовательном прогоне
+    inline ResourceUsage thread_usage()
+    {
+        ResourceUsage usage;
+#if defined(RUSAGE_THREAD) || defined(RUSAGE_SELF)
+        struct rusage ru;
+#if defined(RUSAGE_THREAD)
+        const int who = RUSAGE_THREAD;
+#else
+        const int who = RUSAGE_SELF;
+#endif
+        if (getrusage(who, &ru) == 0)
+        {
+            usage.user_us = ru.ru_utime.tv_sec * 1e6 + ru.ru_utime.tv_usec;
+            usage.sys_us = ru.ru_stime.tv_sec * 1e6 + ru.ru_stime.tv_usec;
+            usage.voluntary_switches = static_cast<std::uint64_t>(ru.ru_nvcsw);
+            usage.involuntary_switches = static_cast<std::uint64_t>(ru.ru_nivcsw);
+            usage.minor_faults = static_cast<std::uint64_t>(ru.ru_minflt);
+            usage.major_faults = static_cast<std::uint64_t>(ru.ru_majflt);
+        }
+#endif
+        return usage;
+    }
 } // namespace detail
 
 namespace test
@@ -81,20 +203,67 @@ namespace test
         const char *file;
         int line;
         TestFunc func;
+        // Метки вида "[fast][db]" или nullptr
+        const char *tags;
+        // Свой предел времени, мс (0 — общий --test-timeout)
+        unsigned timeout_ms;
+        // Следующий зарегистрированный тест (узел списка registry())
+        TestCase *next;
     };
 
-    inline std::vector<TestCase> &registry()
+    // Все зарегистрированные тесты. Узлы лежат в статических Registrar,
+    // поэтому регистрация не трогает кучу
+    inline guard::detail::IntrusiveList<TestCase> &registry()
     {
-        static std::vector<TestCase> instance;
+        static guard::detail::IntrusiveList<TestCase> instance;
         return instance;
     }
 
+    // Декоратор TEST_CASE: предел времени теста для сторожа таймаутов,
+    // TEST_CASE("name", guard::test::timeout_ms(500))
+    struct Timeout
+    {
+        unsigned ms;
+    };
+
+    inline Timeout timeout_ms(unsigned ms)
+    {
+        return Timeout{ms};
+    }
+
     struct Registrar
     {
         Registrar(const char *name, const char *file, int line, TestFunc func)
+            : node{name, file, line, func, nullptr, 0, nullptr}
+        {
+            registry().push_back(&node);
+        }
+
+        // Форма для TEST_CASE("name", "[tags]"): аргументы макроса идут в конце
+        Registrar(const char *file, int line, TestFunc func, const char *name,
+                  const char *tags = nullptr)
+            : node{name, file, line, func, tags, 0, nullptr}
+        {
+            registry().push_back(&node);
+        }
+
+        Registrar(const char *file, int line, TestFunc func, const char *name, Timeout timeout)
+            : node{name, file, line, func, nullptr, timeout.ms, nullptr}
+        {
+            registry().push_back(&node);
+        }
+
+        Registrar(const char *file, int line, TestFunc func, const char *name,
+                  const char *tags, Timeout timeout)
+            : node{name, file, line, func, tags, timeout.ms, nullptr}
         {
-            registry().push_back(TestCase{name, file, line, func});
+            registry().push_back(&node);
         }
+
+        Registrar(const Registrar &) = delete;
+        Registrar &operator=(const Registrar &) = delete;
+
+        TestCase node;
     };
 
     struct RunnerStats
@@ -102,6 +271,13 @@ namespace test
         int total = 0;
         int passed = 0;
         int failed = 0;
+
+        void merge(const RunnerStats &other)
+        {
+            total += other.total;
+            passed += other.passed;
+            failed += other.failed;
+        }
     };
     struct ModuleStats
     {
@@ -111,6 +287,109 @@ namespace test
         int tests_failed = 0;
         unsigned long long asserts_total = 0;
         unsigned long long asserts_failed = 0;
+        unsigned long long alloc_count = 0;
+        unsigned long long alloc_bytes = 0;
+        // Наибольший пик живой памяти среди тестов модуля
+        unsigned long long alloc_peak = 0;
+        // Суммарное время и ресурсы тестов модуля
+        double wall_us = 0;
+        guard::detail::ResourceUsage usage;
+        // Аппаратные счётчики (--perf-counters)
+        guard::perf::Counts perf;
+
+        void merge(const ModuleStats &other)
+        {
+            if (file.empty())
+                file = other.file;
+            tests_total += other.tests_total;
+            tests_passed += other.tests_passed;
+            tests_failed += other.tests_failed;
+            asserts_total += other.asserts_total;
+            asserts_failed += other.asserts_failed;
+            alloc_count += other.alloc_count;
+            alloc_bytes += other.alloc_bytes;
+            alloc_peak = std::max(alloc_peak, other.alloc_peak);
+            wall_us += other.wall_us;
+            usage += other.usage;
+            perf += other.perf;
+        }
+    };
+
+    // Параметры прогона, которые разбирает GUARD_TEST_MAIN
+    struct RunOptions
+    {
+        // nullptr -> запускать все тесты; иначе выражение отбора по имени
+        // (см. guard::detail::Selector), как и элементы test_include
+        const char *test_filter = nullptr;
+        // Выражения отбора: имена/метки и файлы, включения и исключения
+        std::vector<const char *> test_include;
+        std::vector<const char *> test_exclude;
+        std::vector<const char *> file_include;
+        std::vector<const char *> file_exclude;
+        // Только напечатать выбранные тесты, не запуская их
+        bool list_tests = false;
+        // Число потоков раннера; 0 -> по числу аппаратных потоков
+        unsigned jobs = 1;
+        // Число рабочих процессов (только POSIX); 0 -> тесты в своём процессе
+        unsigned fork_workers = 0;
+        // Шардирование по машинам CI; shard_count == 0 -> без шардов
+        unsigned shard_index = 0;
+        unsigned shard_count = 0;
+        // База длительностей тестов (см. TimingDb): читается для
+        // балансировки шардов и порядка запуска, обновляется после прогона
+        const char *timings_path = nullptr;
+        bool timings_readonly = false;
+        // Запускать бенчмарки (BENCHMARK) вместо тестов
+        bool benchmark = false;
+        bench::Config bench;
+        // Куда сохранить замеры (JSON) и с каким эталоном сравнивать
+        const char *benchmark_out = nullptr;
+        const char *benchmark_baseline = nullptr;
+        bench::CompareConfig bench_compare;
+        // Снимать аппаратные счётчики с каждого теста и бенчмарка (Linux)
+        bool perf_counters = false;
+        // Куда дописывать замеры CHECK_COMPLEXITY (CSV)
+        const char *complexity_csv = nullptr;
+        // Сколько самых долгих тестов показать в отчёте (0 — не показывать)
+        std::size_t durations = 0;
+        // Предел времени одного теста, мс (0 — без предела); зависший тест
+        // снимает сторож, см. detail::run_parallel и ForkPool
+        unsigned test_timeout_ms = 0;
+        // Потоковые отчёты вида "junit:path", "jsonl:path", "tap:path"
+        std::vector<const char *> reporters;
+        // Перехват вывода тестов и сколько байт хвоста хранить (0 — всё)
+        guard::detail::CaptureMode capture = guard::detail::CaptureMode::Stream;
+        std::size_t capture_limit = 64 * 1024;
+    };
+
+    // Итог выполнения одного теста
+    struct TestResult
+    {
+        bool passed = true;
+        std::string error;
+        std::string stdout_output;
+        unsigned long long asserts_total = 0;
+        unsigned long long asserts_failed = 0;
+        // Время выполнения теста: настенное и процессорное (поток), мкс
+        double wall_us = 0;
+        double cpu_us = 0;
+        // Выделения памяти в потоке теста (если подключён подсчёт)
+        unsigned long long alloc_count = 0;
+        unsigned long long alloc_bytes = 0;
+        unsigned long long alloc_peak = 0;
+        // Процессорное время, переключения контекста и страничные ошибки
+        guard::detail::ResourceUsage usage;
+        // Аппаратные счётчики потока теста (пустые без --perf-counters)
+        guard::perf::Counts perf;
+    };
+
+    struct TestSummary
+    {
+        // Позиция теста в отсортированном списке прогона
+        std::size_t index;
+        const TestCase *tc;
+        std::string error;
+        std::string stdout_output;
     };
 
     inline bool &verbose()
@@ -124,107 +403,219 @@ namespace test
         verbose() = value;
     }
 
-    // test_filter == nullptr -> запускать все тесты
-    inline int run_all(const char *test_filter, std::ostream &os = std::cout)
+    namespace detail
     {
-        RunnerStats stats;
-        std::map<std::string, ModuleStats> modules;
-
-        using guard::detail::Color;
-        using guard::detail::ColorScope;
+        // Куда пишет std::cout текущего потока; nullptr -> в исходный буфер
+        inline std::streambuf *&capture_target()
+        {
+            static thread_local std::streambuf *target = nullptr;
+            return target;
+        }
 
-        struct TestSummary
+        // Буфер-диспетчер, который на время прогона ставится в std::cout.
+        // Каждый поток раннера направляет вывод в собственный буфер
+        // перехвата, поэтому подменять rdbuf на каждый тест не нужно.
+        class CoutDispatchBuf : public std::streambuf
         {
-            const TestCase *tc;
-            std::string error;
-            std::string stdout_output;
+        public:
+            explicit CoutDispatchBuf(std::streambuf *fallback)
+                : m_fallback(fallback)
+            {
+            }
+
+            std::streambuf *fallback() const
+            {
+                return m_fallback;
+            }
+
+        protected:
+            int_type overflow(int_type ch) override
+            {
+                if (traits_type::eq_int_type(ch, traits_type::eof()))
+                    return traits_type::not_eof(ch);
+                return target()->sputc(traits_type::to_char_type(ch));
+            }
+
+            std::streamsize xsputn(const char *s, std::streamsize n) override
+            {
+                return target()->sputn(s, n);
+            }
+
+            int sync() override
+            {
+                return target()->pubsync();
+            }
+
+        private:
+            std::streambuf *target() const
+            {
+                std::streambuf *t = capture_target();
+                return t ? t : m_fallback;
+            }
+
+            std::streambuf *m_fallback;
         };
 
-        std::vector<TestSummary> failures;
+        class CoutDispatch
+        {
+        public:
+            CoutDispatch() : m_buf(std::cout.rdbuf())
+            {
+                std::cout.rdbuf(&m_buf);
+            }
 
-        // Копируем и сортируем тесты по файлу, строке и имени
-        auto tests = registry();
-        std::sort(tests.begin(), tests.end(), [](const TestCase &lhs, const TestCase &rhs) {
-            const std::string lhs_file(lhs.file ? lhs.file : "");
-            const std::string rhs_file(rhs.file ? rhs.file : "");
-            if (lhs_file < rhs_file)
-                return true;
-            if (rhs_file < lhs_file)
-                return false;
-            if (lhs.line != rhs.line)
-                return lhs.line < rhs.line;
-            const std::string lhs_name(lhs.name ? lhs.name : "");
-            const std::string rhs_name(rhs.name ? rhs.name : "");
-            return lhs_name < rhs_name;
-        });
+            ~CoutDispatch()
+            {
+                std::cout.rdbuf(m_buf.fallback());
+            }
+
+        private:
+            CoutDispatchBuf m_buf;
+        };
 
-        for (const auto &tc : tests)
+        // Перехват std::cout текущего потока на время жизни объекта
+        struct CaptureScope
         {
-            if (test_filter &&
-                std::string(tc.name).find(test_filter) == std::string::npos)
-                continue;
+            std::streambuf *old_target;
 
-            if (verbose())
+            explicit CaptureScope(std::streambuf *target)
+                : old_target(capture_target())
             {
-                ColorScope scope(os, Color::Yellow);
-                os << "Running test: \"" << tc.name << "\"";
-                if (tc.file)
-                    os << " (" << tc.file << ":" << tc.line << ")";
-                os << "\n";
+                capture_target() = target;
+            }
+
+            ~CaptureScope()
+            {
+                capture_target() = old_target;
             }
+        };
+
+        // Затраты построения общих фикстур в потоке (guard::fixture),
+        // накопленные с начала работы потока
+        struct SetupCost
+        {
+            double wall_us = 0;
+            double cpu_us = 0;
+            guard::detail::ResourceUsage usage;
+            guard::perf::Counts perf;
+        };
 
-            ++stats.total;
+        struct SetupMeterState
+        {
+            // Вложенность: фикстура может строиться из другой фикстуры,
+            // замер ведёт только внешний уровень
+            unsigned depth = 0;
+            std::chrono::steady_clock::time_point wall_start;
+            double cpu_start = 0;
+            guard::detail::ResourceUsage usage_start;
+            guard::perf::Counts perf_start;
+            SetupCost total;
+        };
 
-            auto &mod = modules[tc.file];
-            if (mod.file.empty())
-                mod.file = tc.file;
-            ++mod.tests_total;
+        inline SetupMeterState &setup_meter_state()
+        {
+            static thread_local SetupMeterState state;
+            return state;
+        }
 
-            guard_check_error_msg.clear();
+        inline const SetupCost &thread_setup_cost()
+        {
+            return setup_meter_state().total;
+        }
 
-            guard_check_env_t &env = guard_check_env();
-            const auto asserts_before_total = env.assert_total;
-            const auto asserts_before_failed = env.assert_failed;
+        inline void setup_begin()
+        {
+            SetupMeterState &state = setup_meter_state();
+            if (state.depth++ > 0)
+                return;
+            state.wall_start = std::chrono::steady_clock::now();
+            state.cpu_start = guard::detail::thread_cpu_us();
+            state.usage_start = guard::detail::thread_usage();
+            state.perf_start =
+                guard::perf::enabled() ? guard::perf::thread_counts() : guard::perf::Counts();
+        }
 
-            bool test_passed = true;
-            std::string test_error;
+        inline void setup_end()
+        {
+            SetupMeterState &state = setup_meter_state();
+            if (state.depth == 0 || --state.depth > 0)
+                return;
+            if (!state.perf_start.empty())
+                state.total.perf += guard::perf::thread_counts() - state.perf_start;
+            state.total.usage += guard::detail::thread_usage() - state.usage_start;
+            state.total.cpu_us += guard::detail::thread_cpu_us() - state.cpu_start;
+            state.total.wall_us += std::chrono::duration<double, std::micro>(
+                                       std::chrono::steady_clock::now() - state.wall_start)
+                                       .count();
+        }
 
-            // Перехватываем std::cout на время выполнения теста
-            std::ostringstream captured_stdout;
-            struct CoutRedirect
-            {
-                std::ostream &os;
-                std::streambuf *old_buf;
+        inline void install_setup_meter()
+        {
+            guard::fixture::SetupMeter &meter = guard::fixture::setup_meter();
+            meter.begin = &setup_begin;
+            meter.end = &setup_end;
+        }
 
-                CoutRedirect(std::ostream &os_, std::streambuf *new_buf)
-                    : os(os_), old_buf(os_.rdbuf(new_buf))
-                {
-                }
+        // Счётчики perf теста без построения фикстур, накопленного от
+        // setup_start до setup; без построения набор событий не меняется
+        inline guard::perf::Counts without_setup(const guard::perf::Counts &test,
+                                                 const guard::perf::Counts &setup,
+                                                 const guard::perf::Counts &setup_start)
+        {
+            if (setup.empty())
+                return test;
+            return test - (setup_start.empty() ? setup : setup - setup_start);
+        }
 
-                ~CoutRedirect()
-                {
-                    os.rdbuf(old_buf);
-                }
-            } _guard_cout_redirect(std::cout, captured_stdout.rdbuf());
+        // Выполняет body в текущем потоке под защитой среды проверки.
+        // Ошибки копятся в поточной среде, вывод в std::cout (или в
+        // дескрипторы 1 и 2, см. capture_settings()) перехватывается в
+        // буфер потока, который переиспользуется между тестами; в
+        // результат попадает только хвост вывода проваленного теста.
+        template <typename Body>
+        inline TestResult run_guarded(const char *name, Body &&body)
+        {
+            TestResult result;
+
+            const guard_check_counters_t &counters = guard_check_counters();
+            const auto asserts_before_total = counters.assert_total;
+            const auto asserts_before_failed = counters.assert_failed;
+
+            const guard::detail::CaptureSettings &settings = guard::detail::capture_settings();
+            guard::detail::TailStreamBuf &captured = guard::detail::thread_capture_buf();
+            captured.buffer.prepare(settings.limit);
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+            const bool fd_captured = settings.mode == guard::detail::CaptureMode::Fd &&
+                                     guard::detail::fd_capture().begin();
+#else
+            const bool fd_captured = false;
+#endif
+            // При перехвате дескрипторов std::cout идёт в исходный буфер,
+            // а через него — в уже перенаправленный stdout
+            CaptureScope capture(
+                settings.mode == guard::detail::CaptureMode::Stream ? &captured : nullptr);
+
+            const auto wall_start = std::chrono::steady_clock::now();
+            static const bool meter_installed = (install_setup_meter(), true);
+            (void)meter_installed;
+            const SetupCost setup_start = thread_setup_cost();
+            const double cpu_start = guard::detail::thread_cpu_us();
+            const guard::detail::ResourceUsage usage_start = guard::detail::thread_usage();
+            const bool count_perf = guard::perf::enabled();
+            const guard::perf::Counts perf_start =
+                count_perf ? guard::perf::thread_counts() : guard::perf::Counts();
+            alloc::Scope allocs;
 
             GUARD_CHECK_ENV_START()
             {
                 try
                 {
-                    tc.func();
+                    body();
 
-                    if (guard_check_error_msg.empty())
-                    {
-                        ++stats.passed;
-                        ++mod.tests_passed;
-                        test_passed = true;
-                    }
-                    else
+                    if (guard_check_env_failed())
                     {
-                        ++stats.failed;
-                        ++mod.tests_failed;
-                        test_passed = false;
-                        test_error = guard_check_error_msg;
+                        result.passed = false;
+                        result.error = guard_check_env_render();
                     }
                 }
                 catch (const guard_check_exception &)
@@ -236,7 +627,7 @@ namespace test
                 {
                     std::string msg =
                         std::string("Unexpected std::exception in test \"") +
-                        tc.name + "\": " + ex.what();
+                        name + "\": " + ex.what();
                     GUARD_CHECK_ENV_RAISE_SET(msg);
                     GUARD_CHECK_ENV_RAISE_IMPL();
                 }
@@ -244,180 +635,2157 @@ namespace test
                 {
                     std::string msg =
                         std::string("Unexpected non-std exception in test \"") +
-                        tc.name + "\"";
+                        name + "\"";
                     GUARD_CHECK_ENV_RAISE_SET(msg);
                     GUARD_CHECK_ENV_RAISE_IMPL();
                 }
             }
             GUARD_CHECK_ENV_ERROR_HANDLER()
             {
-                ++stats.failed;
-                ++mod.tests_failed;
-                test_passed = false;
-                if (!guard_check_error_msg.empty())
-                    test_error = guard_check_error_msg;
+                result.passed = false;
+                result.error = guard_check_env_render();
             }
 
-            const auto asserts_after_total = env.assert_total;
-            const auto asserts_after_failed = env.assert_failed;
-            mod.asserts_total += (asserts_after_total - asserts_before_total);
-            mod.asserts_failed += (asserts_after_failed - asserts_before_failed);
+            result.alloc_count = allocs.count();
+            result.alloc_bytes = allocs.bytes();
+            result.alloc_peak = allocs.peak();
 
-            if (!test_passed)
-            {
-                failures.push_back(TestSummary{
-                    &tc,
-                    std::move(test_error),
-                    captured_stdout.str()});
-            }
+            // Построение общих фикстур — не затраты теста
+            const SetupCost &setup = thread_setup_cost();
+            if (count_perf)
+                result.perf = without_setup(guard::perf::thread_counts() - perf_start,
+                                            setup.perf,
+                                            setup_start.perf);
+            result.usage = (guard::detail::thread_usage() - usage_start) -
+                           (setup.usage - setup_start.usage);
+            result.cpu_us = guard::detail::thread_cpu_us() - cpu_start -
+                            (setup.cpu_us - setup_start.cpu_us);
+            result.wall_us = std::chrono::duration<double, std::micro>(
+                                 std::chrono::steady_clock::now() - wall_start)
+                                 .count() -
+                             (setup.wall_us - setup_start.wall_us);
+            result.asserts_total = counters.assert_total - asserts_before_total;
+            result.asserts_failed = counters.assert_failed - asserts_before_failed;
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+            if (fd_captured)
+                guard::detail::fd_capture().end(captured.buffer, !result.passed);
+#else
+            (void)fd_captured;
+#endif
+            if (!result.passed)
+                result.stdout_output = captured.buffer.str();
+            return result;
+        }
+
+        // Фатальный провал с сообщением (FAIL, CHECK_THROWS и т.п.)
+        [[noreturn]] GUARD_COLD inline void fail_at(const char *file, int line, const std::string &msg)
+        {
+            GUARD_CHECK_ENV_COUNT_ASSERT(false);
+            GUARD_CHECK_ENV_APPEND(std::string("Test assertion failed at ") + file +
+                                   ":" + guard::detail::to_string(line) + ": " + msg);
+            GUARD_CHECK_ENV_RAISE_IMPL();
         }
+    } // namespace detail
 
-        os << "=======================\n";
-        os << "Per-module summary:\n";
-        for (const auto &entry : modules)
+    // Выполняет один тест в текущем потоке
+    inline TestResult run_test(const TestCase &tc)
+    {
+        return detail::run_guarded(tc.name, tc.func);
+    }
+
+    namespace detail
+    {
+        // Длительность одного теста для базы длительностей
+        struct TimingSample
+        {
+            const TestCase *tc;
+            double wall_us;
+            double cpu_us;
+        };
+
+        // Замер одного теста для отчёта --durations
+        struct DurationSample
         {
-            const auto &mod = entry.second;
+            const TestCase *tc;
+            double wall_us;
+            guard::detail::ResourceUsage usage;
+        };
 
-            Color mod_color =
-                (mod.tests_failed > 0 || mod.asserts_failed > 0)
-                    ? Color::Red
-                    : Color::Green;
+        // Порядок кучи: на вершине самый быстрый из отобранных тестов
+        inline bool slower(const DurationSample &lhs, const DurationSample &rhs)
+        {
+            return lhs.wall_us > rhs.wall_us;
+        }
 
+        // Потоковые отчёты прогона (--reporter). Потоки раннера передают
+        // сюда каждый тест сразу после завершения
+        class ReportSink
+        {
+        public:
+            void add(std::unique_ptr<report::Reporter> reporter)
             {
-                ColorScope scope(os, mod_color);
-                os << mod.file << ":\n";
+                m_reporters.push_back(std::move(reporter));
             }
 
-            os << "  Tests   : " << mod.tests_total
-               << " (passed " << mod.tests_passed
-               << ", failed " << mod.tests_failed << ")\n";
-            os << "  Asserts : " << mod.asserts_total;
-            if (mod.asserts_failed > 0)
-                os << " (failed " << mod.asserts_failed << ")";
-            os << "\n";
-        }
+            bool empty() const
+            {
+                return m_reporters.empty();
+            }
+
+            void begin(std::size_t tests)
+            {
+                for (auto &reporter : m_reporters)
+                    reporter->begin(tests);
+            }
+
+            void test(const TestCase &tc, const TestResult &result)
+            {
+                const report::Record record = {tc.name,
+                                               tc.file,
+                                               tc.line,
+                                               tc.tags,
+                                               result.passed,
+                                               result.wall_us,
+                                               result.cpu_us,
+                                               result.asserts_total,
+                                               result.asserts_failed,
+                                               result.alloc_count,
+                                               result.alloc_bytes,
+                                               &result.error,
+                                               &result.stdout_output,
+                                               &result.perf};
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (auto &reporter : m_reporters)
+                    reporter->test(record);
+            }
+
+            void end(const report::Totals &totals)
+            {
+                for (auto &reporter : m_reporters)
+                    reporter->end(totals);
+            }
+
+        private:
+            std::mutex m_mutex;
+            std::vector<std::unique_ptr<report::Reporter>> m_reporters;
+        };
 
-        guard_check_env_t &env = guard_check_env();
-        os << "=======================\n";
+        // Накопленная статистика одного потока раннера. Потоки пишут
+        // только в свой экземпляр, слияние выполняется после join.
+        struct RunTally
         {
-            ColorScope summary_scope(os, stats.failed == 0 ? Color::Green : Color::Red);
+            RunnerStats stats;
+            // Ключ — __FILE__ теста; строки сравниваются без копирования
+            std::map<const char *, ModuleStats, guard::detail::CStrLess> modules;
+            std::vector<TestSummary> failures;
+            // Заполняется, только если прогон обновляет базу длительностей
+            bool collect_timings = false;
+            std::vector<TimingSample> timings;
+            // N самых долгих тестов (--durations): куча ограниченного
+            // размера, память не зависит от числа тестов
+            std::size_t durations_limit = 0;
+            std::vector<DurationSample> slowest;
+            // Потоковые отчёты; при них подробности для итоговой сводки
+            // хранятся только для первых detail_limit провалов потока,
+            // остальные провалы лишь считаются (полный текст — в отчётах)
+            ReportSink *sink = nullptr;
+            std::size_t detail_limit = 0;
+            unsigned long long details_dropped = 0;
 
-            os << "Overall summary:\n";
+            void record(std::size_t index, const TestCase &tc, TestResult &&result)
+            {
+                ++stats.total;
+                if (sink)
+                    sink->test(tc, result);
+                // Для упавшего рабочего процесса время неизвестно (0)
+                if (collect_timings && result.wall_us > 0)
+                    timings.push_back(TimingSample{&tc, result.wall_us, result.cpu_us});
+
+                auto &mod = modules[tc.file];
+                if (mod.file.empty())
+                    mod.file = tc.file;
+                ++mod.tests_total;
+                mod.asserts_total += result.asserts_total;
+                mod.asserts_failed += result.asserts_failed;
+                mod.alloc_count += result.alloc_count;
+                mod.alloc_bytes += result.alloc_bytes;
+                mod.alloc_peak = std::max(mod.alloc_peak, result.alloc_peak);
+                mod.wall_us += result.wall_us;
+                mod.usage += result.usage;
+                mod.perf += result.perf;
+                if (durations_limit > 0)
+                    add_duration(DurationSample{&tc, result.wall_us, result.usage});
+
+                if (result.passed)
+                {
+                    ++stats.passed;
+                    ++mod.tests_passed;
+                    return;
+                }
 
-            os << "Tests run : " << stats.total << "\n";
+                ++stats.failed;
+                ++mod.tests_failed;
+                if (detail_limit > 0 && failures.size() >= detail_limit)
+                {
+                    ++details_dropped;
+                    return;
+                }
+                failures.push_back(TestSummary{index,
+                                               &tc,
+                                               std::move(result.error),
+                                               std::move(result.stdout_output)});
+            }
 
-            os << "Passed    : ";
+            void merge(RunTally &&other)
             {
-                ColorScope passed_scope(os, stats.passed > 0 ? Color::Green : Color::Default);
-                os << stats.passed;
+                stats.merge(other.stats);
+                for (const auto &entry : other.modules)
+                    modules[entry.first].merge(entry.second);
+                for (auto &f : other.failures)
+                    failures.push_back(std::move(f));
+                details_dropped += other.details_dropped;
+                for (const auto &sample : other.slowest)
+                    add_duration(sample);
+                timings.insert(timings.end(), other.timings.begin(), other.timings.end());
             }
-            os << "\n";
 
-            os << "Failed    : ";
+            void add_duration(const DurationSample &sample)
             {
-                ColorScope failed_scope(os, stats.failed > 0 ? Color::Red : Color::Default);
-                os << stats.failed;
+                if (slowest.size() < durations_limit)
+                {
+                    slowest.push_back(sample);
+                    std::push_heap(slowest.begin(), slowest.end(), slower);
+                }
+                else if (sample.wall_us > slowest.front().wall_us)
+                {
+                    std::pop_heap(slowest.begin(), slowest.end(), slower);
+                    slowest.back() = sample;
+                    std::push_heap(slowest.begin(), slowest.end(), slower);
+                }
             }
+        };
+
+        inline void announce(std::ostream &os, const TestCase &tc)
+        {
+            using guard::detail::Color;
+            using guard::detail::ColorScope;
+
+            ColorScope scope(os, Color::Yellow);
+            os << "Running test: \"" << tc.name << "\"";
+            if (tc.file)
+                os << " (" << tc.file << ":" << tc.line << ")";
             os << "\n";
         }
-        os << "Asserts   : " << env.assert_total
-           << " (failed " << env.assert_failed << ")\n";
 
-        os << "=======================\n";
+        // Предел времени теста: свой из TEST_CASE или общий
+        inline unsigned effective_timeout(const TestCase &tc, unsigned global_ms)
         {
-            ColorScope scope(os, failures.empty() ? Color::Green : Color::Red);
-            os << "Failures detail:\n";
+            return tc.timeout_ms ? tc.timeout_ms : global_ms;
         }
-        if (failures.empty())
+
+        inline TestResult timeout_result(const TestCase &tc, unsigned ms, double wall_us,
+                                         std::string output, const char *action)
         {
-            os << "No test failures.\n";
+            TestResult result;
+            result.passed = false;
+            result.error = std::string("Test \"") + tc.name + "\" timed out after " +
+                           guard::detail::to_string(ms) + " ms (" + action + ")";
+            result.stdout_output = std::move(output);
+            result.wall_us = wall_us;
+            return result;
         }
-        else
+
+        // Сообщение о зависшем тесте печатается сразу, не дожидаясь отчёта
+        inline void report_timeout(std::ostream &os, const TestCase &tc, const TestResult &result)
         {
-            for (const auto &f : failures)
+            using guard::detail::Color;
+            using guard::detail::ColorScope;
+
             {
-                {
-                    ColorScope scope(os, Color::Red);
-                    os << f.tc->file << ":" << f.tc->line
-                       << " in test \"" << f.tc->name << "\"\n";
-                }
-                if (!f.error.empty())
-                    os << f.error << "\n";
-                if (!f.stdout_output.empty())
-                {
-                    os << "Captured stdout:\n";
-                    os << f.stdout_output << "\n";
-                }
-                os << "-----------------------\n";
+                ColorScope scope(os, Color::Red);
+                os << tc.file << ":" << tc.line << ": " << result.error << "\n";
             }
+            if (!result.stdout_output.empty())
+                os << "Captured output so far:\n" << result.stdout_output << "\n";
+            os.flush();
         }
 
-        return stats.failed ? 1 : 0;
-    }
+        // Потоки раннера, брошенные сторожем в зависшем тесте. Их нельзя
+        // дождаться, поэтому run_main завершает процесс без деструкторов
+        // статиков, которые эти потоки могут ещё использовать
+        inline std::atomic<unsigned> &abandoned_threads()
+        {
+            static std::atomic<unsigned> count{0};
+            return count;
+        }
 
-    inline int run_all(std::ostream &os = std::cout)
-    {
-        return run_all(nullptr, os);
-    }
-} // namespace test
-} // namespace guard
+        // Очередь работ одного потока: владелец забирает тесты с головы,
+        // простаивающие потоки воруют с хвоста.
+        class WorkQueue
+        {
+        public:
+            void push(std::size_t index)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_items.push_back(index);
+            }
 
-// ---------- внутренняя склейка имён ----------
-#define GUARD_TEST_CONCAT_IMPL(a, b) a##b
-#define GUARD_TEST_CONCAT(a, b) GUARD_TEST_CONCAT_IMPL(a, b)
+            bool pop(std::size_t &index)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_items.empty())
+                    return false;
+                index = m_items.front();
+                m_items.pop_front();
+                return true;
+            }
 
-// ---------- PUBLIC API: TEST_CASE ----------
-//
-// TEST_CASE("name") {
-//     CHECK(...);
-// }
-#ifdef __COUNTER__
-#define GUARD_TEST_UNIQUE_ID __COUNTER__
-#else
-#define GUARD_TEST_UNIQUE_ID __LINE__
-#endif
+            bool steal(std::size_t &index)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_items.empty())
+                    return false;
+                index = m_items.back();
+                m_items.pop_back();
+                return true;
+            }
 
-#define GUARD_TEST_CASE_IMPL(name, id)                                         \
-    static void GUARD_TEST_CONCAT(guard_test_func_, id)();                     \
-    static ::guard::test::Registrar GUARD_TEST_CONCAT(guard_test_reg_, id)(    \
-        name,                                                                  \
-        __FILE__,                                                              \
-        __LINE__,                                                              \
-        &GUARD_TEST_CONCAT(guard_test_func_, id));                             \
-    static void GUARD_TEST_CONCAT(guard_test_func_, id)()
+        private:
+            std::mutex m_mutex;
+            std::deque<std::size_t> m_items;
+        };
 
-#define TEST_CASE(name) GUARD_TEST_CASE_IMPL(name, GUARD_TEST_UNIQUE_ID)
+        // Что сейчас выполняет поток раннера; читается сторожем таймаутов
+        struct WatchSlot
+        {
+            std::mutex mutex;
+            // Поколение потока слота: сторож увеличивает его, бросая
+            // зависший поток, и запускает вместо него новый
+            unsigned generation = 0;
+            const TestCase *tc = nullptr;
+            std::size_t index = 0;
+            unsigned timeout_ms = 0;
+            std::chrono::steady_clock::time_point start;
+            guard::detail::TailStreamBuf *output = nullptr;
+        };
 
-// ---------- Алисы CHECK* / REQUIRE* на GUARD_* ----------
+        // order — порядок запуска (индексы в tests). Если longest_first,
+        // order отсортирован по убыванию ожидаемой длительности и тесты
+        // раздаются по кругу, чтобы каждый поток начинал с самых долгих.
+        //
+        // watchdog — тесты выполняют отдельные потоки (и при jobs == 1), а
+        // вызывающий поток следит за пределом времени: тест, превысивший
+        // его, засчитывается проваленным с выводом на момент срабатывания,
+        // а его поток бросается и заменяется новым, который продолжает
+        // очередь. Результат брошенного потока, если тест всё же
+        // завершится, отбрасывается.
+        inline void run_parallel(const std::vector<const TestCase *> &tests,
+                                 const std::vector<std::size_t> &order,
+                                 bool longest_first,
+                                 std::vector<RunTally> &tallies,
+                                 std::ostream &os,
+                                 bool watchdog = false,
+                                 unsigned timeout_ms = 0)
+        {
+            const std::size_t jobs = tallies.size();
+            std::vector<WorkQueue> queues(jobs);
 
-#ifndef GUARD_TEST_NO_CHECK_ALIASES
-#define CHECK(...) GUARD_CHECK(__VA_ARGS__)
-#define CHECK_FALSE(expr) GUARD_CHECK_FALSE(expr)
-#define CHECK_EQ(a, b) GUARD_CHECK_EQ(a, b)
-#define CHECK_NEQ(a, b) GUARD_CHECK_NEQ(a, b)
-#define CHECK_LT(a, b) GUARD_CHECK_LT(a, b)
-#define CHECK_GT(a, b) GUARD_CHECK_GT(a, b)
+            // Без истории раздаём непрерывными блоками: соседние тесты
+            // одного файла чаще всего выполняются одним потоком
+            for (std::size_t k = 0; k < order.size(); ++k)
+                queues[longest_first ? k % jobs : k * jobs / order.size()].push(order[k]);
 
-#define REQUIRE(...) GUARD_REQUIRE(__VA_ARGS__)
-#define REQUIRE_FALSE(expr) GUARD_REQUIRE_FALSE(expr)
-#define REQUIRE_EQ(a, b) GUARD_REQUIRE_EQ(a, b)
-#define REQUIRE_NEQ(a, b) GUARD_REQUIRE_NEQ(a, b)
-#define REQUIRE_LT(a, b) GUARD_REQUIRE_LT(a, b)
-#define REQUIRE_GT(a, b) GUARD_REQUIRE_GT(a, b)
-#define FAIL(msg) GUARD_TEST_FAIL_MSG(msg)
+            std::mutex os_mutex;
+            // Брошенный поток может вернуться из теста уже после выхода
+            // отсюда: общие с ним слоты живут, пока жив хоть один поток
+            using Slots = std::vector<WatchSlot>;
+            const std::shared_ptr<Slots> slots = std::make_shared<Slots>(watchdog ? jobs : 0);
+            std::mutex done_mutex;
+            std::condition_variable done_cv;
+            std::size_t running = jobs;
+
+            auto worker = [&](std::size_t self, unsigned generation, std::shared_ptr<Slots> own)
+            {
+                std::size_t index = 0;
+                for (;;)
+                {
+                    bool found = queues[self].pop(index);
+                    for (std::size_t k = 1; !found && k < jobs; ++k)
+                        found = queues[(self + k) % jobs].steal(index);
+                    // Новых задач не появляется: пусто везде -> работа окончена
+                    if (!found)
+                        break;
+
+                    const TestCase &tc = *tests[index];
+                    if (verbose())
+                    {
+                        std::lock_guard<std::mutex> lock(os_mutex);
+                        announce(os, tc);
+                    }
+                    if (!watchdog)
+                    {
+                        tallies[self].record(index, tc, run_test(tc));
+                        continue;
+                    }
+
+                    WatchSlot &slot = (*own)[self];
+                    {
+                        std::lock_guard<std::mutex> lock(slot.mutex);
+                        if (slot.generation != generation)
+                            return;
+                        slot.tc = &tc;
+                        slot.index = index;
+                        slot.timeout_ms = effective_timeout(tc, timeout_ms);
+                        slot.start = std::chrono::steady_clock::now();
+                        slot.output = &guard::detail::thread_capture_buf();
+                    }
+                    TestResult result = run_test(tc);
+                    std::lock_guard<std::mutex> lock(slot.mutex);
+                    // Сторож уже засчитал тест и заменил поток
+                    if (slot.generation != generation)
+                        return;
+                    slot.tc = nullptr;
+                    tallies[self].record(index, tc, std::move(result));
+                }
+                std::lock_guard<std::mutex> lock(done_mutex);
+                --running;
+                done_cv.notify_all();
+            };
+
+            std::vector<std::thread> threads;
+            if (!watchdog)
+            {
+                for (std::size_t t = 1; t < jobs; ++t)
+                    threads.emplace_back(worker, t, 0u, slots);
+                worker(0, 0u, slots);
+                for (auto &th : threads)
+                    th.join();
+                return;
+            }
+
+            for (std::size_t t = 0; t < jobs; ++t)
+                threads.emplace_back(worker, t, 0u, slots);
+
+            std::unique_lock<std::mutex> done_lock(done_mutex);
+            while (running > 0)
+            {
+                done_cv.wait_for(done_lock, std::chrono::milliseconds(5));
+                done_lock.unlock();
+                const auto now = std::chrono::steady_clock::now();
+                for (std::size_t t = 0; t < jobs; ++t)
+                {
+                    WatchSlot &slot = (*slots)[t];
+                    std::lock_guard<std::mutex> lock(slot.mutex);
+                    if (!slot.tc || slot.timeout_ms == 0 ||
+                        now - slot.start < std::chrono::milliseconds(slot.timeout_ms))
+                        continue;
+
+                    const TestCase &tc = *slot.tc;
+                    TestResult result = timeout_result(
+                        tc,
+                        slot.timeout_ms,
+                        std::chrono::duration<double, std::micro>(now - slot.start).count(),
+                        slot.output->snapshot(),
+                        "runner thread abandoned");
+                    {
+                        std::lock_guard<std::mutex> os_lock(os_mutex);
+                        report_timeout(os, tc, result);
+                    }
+                    tallies[t].record(slot.index, tc, std::move(result));
+
+                    slot.tc = nullptr;
+                    ++slot.generation;
+                    threads[t].detach();
+                    ++abandoned_threads();
+                    threads[t] = std::thread(worker, t, slot.generation, slots);
+                }
+                done_lock.lock();
+            }
+            done_lock.unlock();
+            for (auto &th : threads)
+                th.join();
+        }
+
+#if GUARD_TEST_FORK_SUPPORTED
+        // ---------- изоляция тестов в пуле дочерних процессов ----------
+
+        inline bool write_all(int fd, const void *data, std::size_t size)
+        {
+            const char *p = static_cast<const char *>(data);
+            while (size > 0)
+            {
+                const ssize_t n = ::write(fd, p, size);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                p += n;
+                size -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        inline bool read_all(int fd, void *data, std::size_t size)
+        {
+            char *p = static_cast<char *>(data);
+            while (size > 0)
+            {
+                const ssize_t n = ::read(fd, p, size);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                p += n;
+                size -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        // Кадр результата: [u64 длина][u8 passed][u64 asserts][u64 failed]
+        // [f64 wall_us][f64 cpu_us][u64 allocs][u64 bytes][u64 peak]
+        // [u64 длина + ошибка][u64 длина + stdout]. Обе стороны живут на одной
+        // машине, поэтому числа передаются в родном представлении.
+        template <typename T>
+        inline void put_raw(std::string &buf, const T &value)
+        {
+            buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        inline void put_string(std::string &buf, const std::string &value)
+        {
+            put_raw(buf, static_cast<std::uint64_t>(value.size()));
+            buf += value;
+        }
+
+        template <typename T>
+        inline bool get_raw(const std::string &buf, std::size_t &pos, T &value)
+        {
+            if (buf.size() - pos < sizeof(value))
+                return false;
+            std::memcpy(&value, buf.data() + pos, sizeof(value));
+            pos += sizeof(value);
+            return true;
+        }
+
+        inline bool get_string(const std::string &buf, std::size_t &pos, std::string &value)
+        {
+            std::uint64_t size = 0;
+            if (!get_raw(buf, pos, size) || buf.size() - pos < size)
+                return false;
+            value.assign(buf.data() + pos, static_cast<std::size_t>(size));
+            pos += static_cast<std::size_t>(size);
+            return true;
+        }
+
+        inline void encode_result(const TestResult &result, std::string &frame)
+        {
+            frame.assign(sizeof(std::uint64_t), '\0');
+            put_raw(frame, static_cast<std::uint8_t>(result.passed ? 1 : 0));
+            put_raw(frame, static_cast<std::uint64_t>(result.asserts_total));
+            put_raw(frame, static_cast<std::uint64_t>(result.asserts_failed));
+            put_raw(frame, result.wall_us);
+            put_raw(frame, result.cpu_us);
+            put_raw(frame, static_cast<std::uint64_t>(result.alloc_count));
+            put_raw(frame, static_cast<std::uint64_t>(result.alloc_bytes));
+            put_raw(frame, static_cast<std::uint64_t>(result.alloc_peak));
+            put_raw(frame, result.usage);
+            put_raw(frame, result.perf);
+            put_string(frame, result.error);
+            put_string(frame, result.stdout_output);
+            const std::uint64_t size = frame.size() - sizeof(std::uint64_t);
+            std::memcpy(&frame[0], &size, sizeof(size));
+        }
+
+        inline bool decode_result(const std::string &payload, TestResult &result)
+        {
+            std::size_t pos = 0;
+            std::uint8_t passed = 0;
+            std::uint64_t asserts_total = 0;
+            std::uint64_t asserts_failed = 0;
+            std::uint64_t alloc_count = 0;
+            std::uint64_t alloc_bytes = 0;
+            std::uint64_t alloc_peak = 0;
+            if (!get_raw(payload, pos, passed) ||
+                !get_raw(payload, pos, asserts_total) ||
+                !get_raw(payload, pos, asserts_failed) ||
+                !get_raw(payload, pos, result.wall_us) ||
+                !get_raw(payload, pos, result.cpu_us) ||
+                !get_raw(payload, pos, alloc_count) ||
+                !get_raw(payload, pos, alloc_bytes) ||
+                !get_raw(payload, pos, alloc_peak) ||
+                !get_raw(payload, pos, result.usage) ||
+                !get_raw(payload, pos, result.perf) ||
+                !get_string(payload, pos, result.error) ||
+                !get_string(payload, pos, result.stdout_output))
+                return false;
+            result.passed = passed != 0;
+            result.asserts_total = asserts_total;
+            result.asserts_failed = asserts_failed;
+            result.alloc_count = alloc_count;
+            result.alloc_bytes = alloc_bytes;
+            result.alloc_peak = alloc_peak;
+            return true;
+        }
+
+        inline const char *signal_name(int sig)
+        {
+            switch (sig)
+            {
+            case SIGSEGV:
+                return "SIGSEGV";
+            case SIGABRT:
+                return "SIGABRT";
+            case SIGBUS:
+                return "SIGBUS";
+            case SIGFPE:
+                return "SIGFPE";
+            case SIGILL:
+                return "SIGILL";
+            case SIGKILL:
+                return "SIGKILL";
+            case SIGTERM:
+                return "SIGTERM";
+            case SIGPIPE:
+                return "SIGPIPE";
+            case SIGTRAP:
+                return "SIGTRAP";
+            default:
+                return "signal";
+            }
+        }
+
+        // Текст ошибки для теста, во время которого умер рабочий процесс
+        inline std::string describe_worker_exit(int status)
+        {
+            std::ostringstream os;
+            if (WIFSIGNALED(status))
+            {
+                const int sig = WTERMSIG(status);
+                os << "Test worker crashed with " << signal_name(sig) << " ("
+                   << sig << ": " << ::strsignal(sig) << ")";
+            }
+            else if (WIFEXITED(status))
+            {
+                os << "Test worker exited with status " << WEXITSTATUS(status)
+                   << " while running the test";
+            }
+            else
+            {
+                os << "Test worker terminated unexpectedly";
+            }
+            return os.str();
+        }
+
+        class ForkPool
+        {
+        public:
+            // timeout_ms — общий предел времени теста (0 — только свои
+            // пределы тестов); зависший рабочий убивается
+            ForkPool(const std::vector<const TestCase *> &tests,
+                     const std::vector<std::size_t> &order,
+                     std::size_t size,
+                     unsigned timeout_ms = 0)
+                : m_tests(tests), m_order(order), m_workers(size), m_timeout_ms(timeout_ms)
+            {
+            }
+
+            ForkPool(const ForkPool &) = delete;
+            ForkPool &operator=(const ForkPool &) = delete;
+
+            ~ForkPool()
+            {
+                for (auto &w : m_workers)
+                {
+                    stop(w);
+                    if (w.capture_fd >= 0)
+                        ::close(w.capture_fd);
+                }
+            }
+
+            void run(RunTally &tally, std::ostream &os)
+            {
+                std::size_t next = 0;
+                std::size_t done = 0;
+                std::string payload;
+                std::vector<pollfd> fds;
+                std::vector<Worker *> polled;
+
+                while (done < m_tests.size())
+                {
+                    for (auto &w : m_workers)
+                    {
+                        if (w.busy || next >= m_tests.size())
+                            continue;
+                        const std::uint64_t index = m_order[next];
+                        if (verbose())
+                            announce(os, *m_tests[m_order[next]]);
+                        // Рабочий умер между тестами — заводим нового и
+                        // отдаём ему тот же тест; если не берёт и он,
+                        // тест проваливается, а не теряется
+                        const unsigned hand_off_attempts = 3;
+                        bool handed = false;
+                        for (unsigned attempt = 0; attempt < hand_off_attempts && !handed; ++attempt)
+                        {
+                            if (w.pid < 0)
+                                spawn(w, os);
+                            handed = write_all(w.request_fd, &index, sizeof(index));
+                            if (!handed)
+                                stop(w);
+                        }
+                        if (!handed)
+                        {
+                            const TestCase &tc = *m_tests[m_order[next]];
+                            TestResult result;
+                            result.passed = false;
+                            result.error = "worker did not accept the test";
+                            ColorScope scope(os, Color::Red);
+                            os << "Test \"" << tc.name << "\" (" << tc.file
+                               << ":" << tc.line << "): " << result.error
+                               << "\n";
+                            ++done;
+                            tally.record(m_order[next++], tc, std::move(result));
+                            continue;
+                        }
+                        w.busy = true;
+                        w.index = m_order[next++];
+                        w.start = std::chrono::steady_clock::now();
+                        w.timeout_ms = effective_timeout(*m_tests[w.index], m_timeout_ms);
+                    }
+
+                    fds.clear();
+                    polled.clear();
+                    for (auto &w : m_workers)
+                    {
+                        if (!w.busy)
+                            continue;
+                        pollfd p;
+                        p.fd = w.result_fd;
+                        p.events = POLLIN;
+                        p.revents = 0;
+                        fds.push_back(p);
+                        polled.push_back(&w);
+                    }
+
+                    // Никто не занят (все тесты розданы или провалены) —
+                    // ждать нечего, poll() с пустым набором повис бы
+                    if (fds.empty())
+                        continue;
+
+                    if (::poll(fds.data(), fds.size(), poll_timeout(polled)) < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        throw std::runtime_error("guard: poll() failed in fork pool");
+                    }
+
+                    const auto now = std::chrono::steady_clock::now();
+                    for (std::size_t k = 0; k < fds.size(); ++k)
+                    {
+                        Worker &w = *polled[k];
+                        const TestCase &tc = *m_tests[w.index];
+                        TestResult result;
+                        if (fds[k].revents == 0)
+                        {
+                            if (w.timeout_ms == 0 ||
+                                now - w.start < std::chrono::milliseconds(w.timeout_ms))
+                                continue;
+                            stop(w);
+                            result = timeout_result(
+                                tc,
+                                w.timeout_ms,
+                                std::chrono::duration<double, std::micro>(now - w.start).count(),
+                                take_output(w),
+                                "worker killed");
+                            report_timeout(os, tc, result);
+                        }
+                        else if (!receive(w, payload, result))
+                        {
+                            result = TestResult();
+                            result.passed = false;
+                            result.error = describe_worker_exit(stop(w));
+                            result.stdout_output = take_output(w);
+                            ColorScope scope(os, Color::Red);
+                            os << "Test \"" << tc.name << "\" (" << tc.file
+                               << ":" << tc.line << "): " << result.error
+                               << "\n";
+                        }
+                        w.busy = false;
+                        ++done;
+                        tally.record(w.index, tc, std::move(result));
+                    }
+                }
+            }
+
+        private:
+            using Color = guard::detail::Color;
+            using ColorScope = guard::detail::ColorScope;
+
+            struct Worker
+            {
+                pid_t pid = -1;
+                int request_fd = -1;
+                int result_fd = -1;
+                bool busy = false;
+                std::size_t index = 0;
+                std::chrono::steady_clock::time_point start;
+                unsigned timeout_ms = 0;
+                // Файл перехвата вывода (--capture=fd), созданный до fork:
+                // вывод убитого или упавшего рабочего остаётся у родителя
+                int capture_fd = -1;
+            };
+
+            // Ожидание до ближайшего предела времени среди занятых рабочих
+            static int poll_timeout(const std::vector<Worker *> &busy)
+            {
+                int wait_ms = -1;
+                const auto now = std::chrono::steady_clock::now();
+                for (const Worker *w : busy)
+                {
+                    if (w->timeout_ms == 0)
+                        continue;
+                    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          w->start + std::chrono::milliseconds(w->timeout_ms) - now)
+                                          .count() +
+                                      1;
+                    const int ms = left < 0 ? 0 : static_cast<int>(left);
+                    if (wait_ms < 0 || ms < wait_ms)
+                        wait_ms = ms;
+                }
+                return wait_ms;
+            }
+
+            // Хвост вывода теста из файла перехвата рабочего (если он есть)
+            static std::string take_output(Worker &w)
+            {
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+                if (w.capture_fd < 0)
+                    return std::string();
+                guard::detail::TailBuffer tail;
+                tail.prepare(guard::detail::capture_settings().limit);
+                guard::detail::FdCapture::read_tail(w.capture_fd, tail);
+                guard::detail::FdCapture::truncate(w.capture_fd);
+                return tail.str();
+#else
+                (void)w;
+                return std::string();
+#endif
+            }
+
+            void spawn(Worker &w, std::ostream &os)
+            {
+                int request[2];
+                int result[2];
+                if (::pipe(request) != 0)
+                    throw std::runtime_error("guard: pipe() failed in fork pool");
+                if (::pipe(result) != 0)
+                {
+                    ::close(request[0]);
+                    ::close(request[1]);
+                    throw std::runtime_error("guard: pipe() failed in fork pool");
+                }
+
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+                if (w.capture_fd < 0 &&
+                    guard::detail::capture_settings().mode == guard::detail::CaptureMode::Fd)
+                    w.capture_fd = guard::detail::FdCapture::create_file();
+#endif
+
+                // Иначе буферы вывода продублируются в дочернем процессе
+                os.flush();
+                std::cout.flush();
+                std::fflush(nullptr);
+
+                const pid_t pid = ::fork();
+                if (pid < 0)
+                {
+                    ::close(request[0]);
+                    ::close(request[1]);
+                    ::close(result[0]);
+                    ::close(result[1]);
+                    throw std::runtime_error("guard: fork() failed in fork pool");
+                }
+
+                if (pid == 0)
+                {
+                    ::close(request[1]);
+                    ::close(result[0]);
+                    // Чужие каналы надо закрыть, иначе родитель не увидит EOF
+                    // при падении соседнего рабочего
+                    for (auto &other : m_workers)
+                    {
+                        if (other.request_fd >= 0)
+                            ::close(other.request_fd);
+                        if (other.result_fd >= 0)
+                            ::close(other.result_fd);
+                        if (&other != &w && other.capture_fd >= 0)
+                            ::close(other.capture_fd);
+                    }
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+                    if (w.capture_fd >= 0)
+                        guard::detail::fd_capture().adopt(w.capture_fd);
+#endif
+                    serve(request[0], result[1]);
+                    // Без деструкторов статиков и сброса унаследованных буферов
+                    ::_exit(0);
+                }
+
+                ::close(request[0]);
+                ::close(result[1]);
+                w.pid = pid;
+                w.request_fd = request[1];
+                w.result_fd = result[0];
+            }
+
+            void serve(int request_fd, int result_fd)
+            {
+                std::uint64_t index = 0;
+                std::string frame;
+                while (read_all(request_fd, &index, sizeof(index)))
+                {
+                    encode_result(run_test(*m_tests[index]), frame);
+                    if (!write_all(result_fd, frame.data(), frame.size()))
+                        break;
+                }
+            }
+
+            bool receive(Worker &w, std::string &payload, TestResult &result)
+            {
+                std::uint64_t size = 0;
+                if (!read_all(w.result_fd, &size, sizeof(size)))
+                    return false;
+                payload.resize(static_cast<std::size_t>(size));
+                if (size > 0 && !read_all(w.result_fd, &payload[0], payload.size()))
+                    return false;
+                return decode_result(payload, result);
+            }
+
+            // Закрывает каналы и дожидается процесса; возвращает его статус
+            int stop(Worker &w)
+            {
+                int status = 0;
+                if (w.request_fd >= 0)
+                    ::close(w.request_fd);
+                if (w.result_fd >= 0)
+                    ::close(w.result_fd);
+                if (w.pid > 0)
+                {
+                    // Живой процесс завершится по EOF запросов; если он
+                    // застрял после сбоя канала — добиваем
+                    if (w.busy)
+                        ::kill(w.pid, SIGKILL);
+                    while (::waitpid(w.pid, &status, 0) < 0 && errno == EINTR)
+                    {
+                    }
+                }
+                w.pid = -1;
+                w.request_fd = -1;
+                w.result_fd = -1;
+                return status;
+            }
+
+            const std::vector<const TestCase *> &m_tests;
+            const std::vector<std::size_t> &m_order;
+            std::vector<Worker> m_workers;
+            unsigned m_timeout_ms;
+        };
+
+        // Запись в канал умершего рабочего не должна убивать раннер
+        struct IgnoreSigpipe
+        {
+            struct sigaction old_action;
+
+            IgnoreSigpipe()
+            {
+                struct sigaction action;
+                std::memset(&action, 0, sizeof(action));
+                action.sa_handler = SIG_IGN;
+                ::sigaction(SIGPIPE, &action, &old_action);
+            }
+
+            ~IgnoreSigpipe()
+            {
+                ::sigaction(SIGPIPE, &old_action, nullptr);
+            }
+        };
+
+        inline void run_forked(const std::vector<const TestCase *> &tests,
+                               const std::vector<std::size_t> &order,
+                               std::size_t workers,
+                               RunTally &tally,
+                               std::ostream &os,
+                               unsigned timeout_ms = 0)
+        {
+            IgnoreSigpipe ignore_sigpipe;
+            ForkPool pool(tests, order, std::min(workers, tests.size()), timeout_ms);
+            pool.run(tally, os);
+        }
+#endif
+
+        // Таблица --durations: самые долгие тесты по настенному времени;
+        // переключения контекста и страничные ошибки — добровольные /
+        // вынужденные и без диска / с диском
+        inline void print_durations(std::ostream &os, std::vector<DurationSample> slowest)
+        {
+            std::sort(slowest.begin(), slowest.end(), slower);
+            os << "=======================\n";
+            os << "Slowest " << slowest.size() << " tests:\n";
+            os << "   wall ms    user ms     sys ms   vcsw  ivcsw   minflt  majflt  test\n";
+            for (const auto &sample : slowest)
+            {
+                char row[128];
+                std::snprintf(row,
+                              sizeof(row),
+                              "%10.3f %10.3f %10.3f %6llu %6llu %8llu %7llu  ",
+                              sample.wall_us / 1e3,
+                              sample.usage.user_us / 1e3,
+                              sample.usage.sys_us / 1e3,
+                              static_cast<unsigned long long>(sample.usage.voluntary_switches),
+                              static_cast<unsigned long long>(sample.usage.involuntary_switches),
+                              static_cast<unsigned long long>(sample.usage.minor_faults),
+                              static_cast<unsigned long long>(sample.usage.major_faults));
+                os << row << sample.tc->name << " (" << sample.tc->file << ":"
+                   << sample.tc->line << ")\n";
+            }
+        }
+
+        // Общие фикстуры, построенные в этом процессе, и время построения
+        inline void print_shared_fixtures(std::ostream &os)
+        {
+            bool header = false;
+            for (const guard::fixture::Shared &f : guard::fixture::shared())
+            {
+                if (!f.built.load(std::memory_order_acquire))
+                    continue;
+                if (!header)
+                {
+                    os << "=======================\n";
+                    os << "Shared fixtures:\n";
+                    os << "  setup ms  fixture\n";
+                    header = true;
+                }
+                char row[32];
+                std::snprintf(row, sizeof(row), "%10.3f  ", f.setup_us / 1e3);
+                os << row << f.name << " (" << f.file << ":" << f.line << ")";
+                if (!f.error.empty())
+                    os << " failed: " << f.error;
+                os << "\n";
+            }
+        }
+
+        inline int print_report(std::ostream &os, const RunTally &tally)
+        {
+            using guard::detail::Color;
+            using guard::detail::ColorScope;
+
+            const RunnerStats &stats = tally.stats;
+            unsigned long long asserts_total = 0;
+            unsigned long long asserts_failed = 0;
+
+            os << "=======================\n";
+            os << "Per-module summary:\n";
+            for (const auto &entry : tally.modules)
+            {
+                const auto &mod = entry.second;
+                asserts_total += mod.asserts_total;
+                asserts_failed += mod.asserts_failed;
+
+                Color mod_color =
+                    (mod.tests_failed > 0 || mod.asserts_failed > 0)
+                        ? Color::Red
+                        : Color::Green;
+
+                {
+                    ColorScope scope(os, mod_color);
+                    os << mod.file << ":\n";
+                }
+
+                os << "  Tests   : " << mod.tests_total
+                   << " (passed " << mod.tests_passed
+                   << ", failed " << mod.tests_failed << ")\n";
+                os << "  Asserts : " << mod.asserts_total;
+                if (mod.asserts_failed > 0)
+                    os << " (failed " << mod.asserts_failed << ")";
+                os << "\n";
+                if (alloc::enabled())
+                    os << "  Allocs  : " << mod.alloc_count << " (bytes "
+                       << mod.alloc_bytes << ", max peak " << mod.alloc_peak
+                       << ")\n";
+                char time[160];
+                std::snprintf(time,
+                              sizeof(time),
+                              "  Time    : %.3f ms (user %.3f ms, sys %.3f ms, "
+                              "ctx switches %llu/%llu, page faults %llu/%llu)\n",
+                              mod.wall_us / 1e3,
+                              mod.usage.user_us / 1e3,
+                              mod.usage.sys_us / 1e3,
+                              static_cast<unsigned long long>(mod.usage.voluntary_switches),
+                              static_cast<unsigned long long>(mod.usage.involuntary_switches),
+                              static_cast<unsigned long long>(mod.usage.minor_faults),
+                              static_cast<unsigned long long>(mod.usage.major_faults));
+                os << time;
+                if (!mod.perf.empty())
+                    os << "  Perf    : " << guard::perf::describe(mod.perf, 0) << "\n";
+            }
+
+            if (!tally.slowest.empty())
+                print_durations(os, tally.slowest);
+            print_shared_fixtures(os);
+
+            os << "=======================\n";
+            {
+                ColorScope summary_scope(os, stats.failed == 0 ? Color::Green : Color::Red);
+
+                os << "Overall summary:\n";
+
+                os << "Tests run : " << stats.total << "\n";
+
+                os << "Passed    : ";
+                {
+                    ColorScope passed_scope(os, stats.passed > 0 ? Color::Green : Color::Default);
+                    os << stats.passed;
+                }
+                os << "\n";
+
+                os << "Failed    : ";
+                {
+                    ColorScope failed_scope(os, stats.failed > 0 ? Color::Red : Color::Default);
+                    os << stats.failed;
+                }
+                os << "\n";
+            }
+            os << "Asserts   : " << asserts_total
+               << " (failed " << asserts_failed << ")\n";
+
+            os << "=======================\n";
+            {
+                ColorScope scope(os, stats.failed == 0 ? Color::Green : Color::Red);
+                os << "Failures detail:\n";
+            }
+            if (stats.failed == 0)
+            {
+                os << "No test failures.\n";
+            }
+            else
+            {
+                for (const auto &f : tally.failures)
+                {
+                    {
+                        ColorScope scope(os, Color::Red);
+                        os << f.tc->file << ":" << f.tc->line
+                           << " in test \"" << f.tc->name << "\"\n";
+                    }
+                    if (!f.error.empty())
+                        os << f.error << "\n";
+                    if (!f.stdout_output.empty())
+                    {
+                        os << "Captured stdout:\n";
+                        os << f.stdout_output << "\n";
+                    }
+                    os << "-----------------------\n";
+                }
+                if (tally.details_dropped > 0)
+                    os << "... " << tally.details_dropped
+                       << " more failed tests, see report files\n";
+            }
+
+            return stats.failed ? 1 : 0;
+        }
+    } // namespace detail
+
+    // База длительностей тестов, ключ — имя, файл и строка теста.
+    // Формат файла: заголовок "guard-timings 2", затем по строке на тест:
+    //   <runs>\t<last_wall_us>\t<last_cpu_us>\t<avg_wall_us>\t<best_wall_us>
+    //   \t<line>\t<file>\t<name>
+    // avg_wall_us — экспоненциальное среднее по прогонам, по нему шарды
+    // балансируются и строится порядок "сначала долгие". Отношение last к
+    // avg и best показывает тесты, которые со временем замедляются.
+    // Файлы старого формата "guard-timings 1" (<wall_us>\t<line>\t<file>
+    // \t<name>) тоже читаются.
+    class TimingDb
+    {
+    public:
+        struct Entry
+        {
+            std::string file;
+            int line = 0;
+            std::string name;
+            unsigned long long runs = 0;
+            double last_wall_us = 0;
+            double last_cpu_us = 0;
+            double avg_wall_us = 0;
+            double best_wall_us = 0;
+        };
+
+        static std::string key(const TestCase &tc)
+        {
+            return key(tc.file ? tc.file : "", tc.line, tc.name ? tc.name : "");
+        }
+
+        bool load(const char *path)
+        {
+            std::ifstream in(path);
+            std::string line;
+            if (!in || !std::getline(in, line))
+                return false;
+
+            std::size_t numeric_fields = 0;
+            if (line == "guard-timings 1")
+                numeric_fields = 1;
+            else if (line == "guard-timings 2")
+                numeric_fields = 5;
+            else
+                return false;
+
+            // Числовые поля, строка, файл; имя — всё до конца строки
+            std::vector<std::string> fields;
+            while (std::getline(in, line))
+            {
+                fields.clear();
+                std::size_t pos = 0;
+                while (fields.size() < numeric_fields + 2)
+                {
+                    const std::size_t tab = line.find('\t', pos);
+                    if (tab == std::string::npos)
+                        break;
+                    fields.push_back(line.substr(pos, tab - pos));
+                    pos = tab + 1;
+                }
+                if (fields.size() != numeric_fields + 2)
+                    continue;
+
+                std::vector<double> numbers(numeric_fields);
+                for (std::size_t f = 0; f < numeric_fields; ++f)
+                    numbers[f] = std::strtod(fields[f].c_str(), nullptr);
+
+                Entry e;
+                e.line = std::atoi(fields[numeric_fields].c_str());
+                e.file = fields[numeric_fields + 1];
+                e.name = line.substr(pos);
+                if (numeric_fields == 1)
+                {
+                    e.runs = 1;
+                    e.last_wall_us = e.avg_wall_us = e.best_wall_us = numbers[0];
+                }
+                else
+                {
+                    e.runs = static_cast<unsigned long long>(numbers[0]);
+                    e.last_wall_us = numbers[1];
+                    e.last_cpu_us = numbers[2];
+                    e.avg_wall_us = numbers[3];
+                    e.best_wall_us = numbers[4];
+                }
+                m_entries[key(e.file, e.line, e.name)] = std::move(e);
+            }
+            return true;
+        }
+
+        // Записывает базу во временный файл и атомарно заменяет им старый
+        bool save(const char *path) const
+        {
+            const std::string tmp = std::string(path) + ".tmp";
+            {
+                std::ofstream out(tmp.c_str(), std::ios::trunc);
+                if (!out)
+                    return false;
+                out << "guard-timings 2\n";
+                for (const auto &entry : m_entries)
+                {
+                    const Entry &e = entry.second;
+                    out << e.runs << '\t' << e.last_wall_us << '\t'
+                        << e.last_cpu_us << '\t' << e.avg_wall_us << '\t'
+                        << e.best_wall_us << '\t' << e.line << '\t' << e.file
+                        << '\t' << e.name << '\n';
+                }
+                if (!out.flush())
+                    return false;
+            }
+            std::remove(path);
+            return std::rename(tmp.c_str(), path) == 0;
+        }
+
+        void update(const TestCase &tc, double wall_us, double cpu_us)
+        {
+            Entry &e = m_entries[key(tc)];
+            if (e.runs == 0)
+            {
+                e.file = tc.file ? tc.file : "";
+                e.line = tc.line;
+                e.name = tc.name ? tc.name : "";
+                e.avg_wall_us = wall_us;
+                e.best_wall_us = wall_us;
+            }
+            else
+            {
+                e.avg_wall_us = 0.7 * e.avg_wall_us + 0.3 * wall_us;
+                e.best_wall_us = std::min(e.best_wall_us, wall_us);
+            }
+            ++e.runs;
+            e.last_wall_us = wall_us;
+            e.last_cpu_us = cpu_us;
+        }
+
+        bool empty() const
+        {
+            return m_entries.empty();
+        }
+
+        const Entry *find(const TestCase &tc) const
+        {
+            auto it = m_entries.find(key(tc));
+            return it == m_entries.end() ? nullptr : &it->second;
+        }
+
+        // Ожидаемая длительность в микросекундах или отрицательное значение
+        double wall_us(const TestCase &tc) const
+        {
+            const Entry *e = find(tc);
+            return e ? e->avg_wall_us : -1.0;
+        }
+
+    private:
+        static std::string key(const std::string &file, int line, const std::string &name)
+        {
+            std::string k(file);
+            k += ':';
+            k += guard::detail::to_string(line);
+            k += ':';
+            k += name;
+            return k;
+        }
+
+        std::unordered_map<std::string, Entry> m_entries;
+    };
+
+    namespace detail
+    {
+        // Оставляет в tests только тесты шарда shard_index из shard_count.
+        // Без истории длительностей тесты раздаются по кругу в порядке
+        // сортировки; с историей — жадной упаковкой "самый долгий тест в
+        // наименее загруженный шард". Результат детерминирован и одинаков
+        // на всех машинах с одинаковым бинарником и файлом длительностей.
+        inline void select_shard(std::vector<const TestCase *> &tests,
+                                 std::size_t shard_index,
+                                 std::size_t shard_count,
+                                 const TimingDb &timings)
+        {
+            std::vector<std::size_t> owner(tests.size());
+
+            if (timings.empty())
+            {
+                for (std::size_t i = 0; i < tests.size(); ++i)
+                    owner[i] = i % shard_count;
+            }
+            else
+            {
+                // Тестам без истории приписываем среднюю длительность
+                std::vector<double> cost(tests.size());
+                double known_sum = 0;
+                std::size_t known = 0;
+                for (std::size_t i = 0; i < tests.size(); ++i)
+                {
+                    cost[i] = timings.wall_us(*tests[i]);
+                    if (cost[i] >= 0)
+                    {
+                        known_sum += cost[i];
+                        ++known;
+                    }
+                }
+                const double fallback = known ? known_sum / known : 1.0;
+                for (auto &c : cost)
+                    if (c < 0)
+                        c = fallback;
+
+                std::vector<std::size_t> order(tests.size());
+                for (std::size_t i = 0; i < order.size(); ++i)
+                    order[i] = i;
+                std::stable_sort(order.begin(),
+                                 order.end(),
+                                 [&](std::size_t lhs, std::size_t rhs) {
+                                     return cost[lhs] > cost[rhs];
+                                 });
+
+                std::vector<double> load(shard_count, 0.0);
+                for (std::size_t i : order)
+                {
+                    const std::size_t target = static_cast<std::size_t>(
+                        std::min_element(load.begin(), load.end()) - load.begin());
+                    owner[i] = target;
+                    load[target] += cost[i];
+                }
+            }
+
+            std::size_t out = 0;
+            for (std::size_t i = 0; i < tests.size(); ++i)
+                if (owner[i] == shard_index)
+                    tests[out++] = tests[i];
+            tests.resize(out);
+        }
+
+        // Порядок тестов в отчёте: по файлу, строке и имени
+        inline bool test_less(const TestCase &lhs, const TestCase &rhs)
+        {
+            return guard::detail::location_less(lhs, rhs);
+        }
+
+        // Разбирает выражения отбора из опций один раз перед прогоном
+        inline guard::detail::Selector make_selector(const RunOptions &options)
+        {
+            guard::detail::Selector selector;
+            selector.include_names(options.test_filter);
+            for (const char *expression : options.test_include)
+                selector.include_names(expression);
+            for (const char *expression : options.test_exclude)
+                selector.exclude_names(expression);
+            for (const char *expression : options.file_include)
+                selector.include_files(expression);
+            for (const char *expression : options.file_exclude)
+                selector.exclude_files(expression);
+            return selector;
+        }
+
+        // Режим --list-tests: по строке на тест, поля через табуляцию
+        // (имя, файл:строка, метки), чтобы скрипты могли резать их cut -f
+        inline void list_tests(std::ostream &os, const std::vector<const TestCase *> &tests)
+        {
+            for (const TestCase *tc : tests)
+            {
+                os << tc->name << '\t' << tc->file << ':' << tc->line << '\t'
+                   << (tc->tags ? tc->tags : "") << '\n';
+            }
+            os.flush();
+        }
+
+        // Порядок запуска: по умолчанию порядок сортировки, с базой
+        // длительностей — по убыванию ожидаемого времени
+        inline std::vector<std::size_t> schedule(const std::vector<const TestCase *> &tests,
+                                                 const TimingDb *timings)
+        {
+            std::vector<std::size_t> order(tests.size());
+            for (std::size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+            if (!timings)
+                return order;
+
+            std::vector<double> cost(tests.size());
+            for (std::size_t i = 0; i < tests.size(); ++i)
+                cost[i] = timings->wall_us(*tests[i]);
+            std::stable_sort(order.begin(),
+                             order.end(),
+                             [&](std::size_t lhs, std::size_t rhs) {
+                                 return cost[lhs] > cost[rhs];
+                             });
+            return order;
+        }
+    } // namespace detail
+
+    // Режим --benchmark: запускает зарегистрированные BENCHMARK вместо
+    // тестов. Бенчмарки идут строго последовательно, чтобы не мешать
+    // друг другу; результат каждого печатается сразу после замера.
+    inline int run_benchmarks(const RunOptions &options, std::ostream &os = std::cout)
+    {
+        using guard::detail::Color;
+        using guard::detail::ColorScope;
+
+        // Для общего отчёта бенчмарки представлены как TestCase без тела
+        auto &all = bench::registry();
+        all.sort(guard::detail::location_less<bench::Benchmark>);
+        const guard::detail::Selector selector = detail::make_selector(options);
+        std::vector<TestCase> cases;
+        std::vector<const bench::Benchmark *> benchmarks;
+        cases.reserve(all.size());
+        benchmarks.reserve(all.size());
+        for (const auto &bm : all)
+        {
+            if (!selector.matches(bm.name, bm.file, nullptr))
+                continue;
+            cases.push_back(TestCase{bm.name, bm.file, bm.line, nullptr, nullptr, 0, nullptr});
+            benchmarks.push_back(&bm);
+        }
+
+        if (options.list_tests)
+        {
+            std::vector<const TestCase *> listed;
+            listed.reserve(cases.size());
+            for (const TestCase &tc : cases)
+                listed.push_back(&tc);
+            detail::list_tests(os, listed);
+            return 0;
+        }
+
+        bench::Baseline baseline;
+        const bool has_baseline = options.benchmark_baseline != nullptr &&
+                                  baseline.load(options.benchmark_baseline);
+        if (options.benchmark_baseline && !has_baseline)
+            os << "Cannot read benchmark baseline \"" << options.benchmark_baseline
+               << "\", regressions are not checked\n";
+
+        std::vector<std::pair<const bench::Benchmark *, bench::Result>> measurements;
+        detail::RunTally tally;
+        {
+            detail::CoutDispatch dispatch;
+            os << "Benchmarks:\n";
+            for (std::size_t i = 0; i < cases.size(); ++i)
+            {
+                const TestCase &tc = cases[i];
+                const bench::Benchmark &bm = *benchmarks[i];
+                if (verbose())
+                    detail::announce(os, tc);
+
+                bench::Result measured;
+                bench::Comparison cmp;
+                const std::vector<double> *reference =
+                    has_baseline ? baseline.find(bm.name) : nullptr;
+                TestResult result = detail::run_guarded(bm.name, [&]() {
+                    measured = bench::measure(bm, options.bench);
+                    if (!reference)
+                        return;
+                    cmp = bench::compare(*reference, measured, options.bench_compare);
+                    GUARD_CHECK_ENV_COUNT_ASSERT(!cmp.regression);
+                    if (cmp.regression)
+                    {
+                        std::ostringstream msg;
+                        msg << "Benchmark regression: median "
+                            << bench::format_ns(cmp.old_median_ns) << "/op -> "
+                            << bench::format_ns(cmp.new_median_ns) << "/op ("
+                            << bench::format_change(cmp.change) << "), Mann-Whitney U p = "
+                            << cmp.p_value << " (alpha "
+                            << options.bench_compare.alpha << ", min effect "
+                            << options.bench_compare.min_effect * 100 << "%)";
+                        GUARD_CHECK_ENV_APPEND(msg.str());
+                    }
+                });
+
+                if (!measured.samples.empty())
+                {
+                    ColorScope scope(os, result.passed ? Color::Default : Color::Red);
+                    os << "  \"" << bm.name << "\": "
+                       << bench::format_ns(measured.median_ns) << "/op"
+                       << " (median), MAD " << bench::format_ns(measured.mad_ns)
+                       << ", min " << bench::format_ns(measured.min_ns);
+                    if (measured.items_per_second > 0)
+                        os << ", " << bench::format_si(measured.items_per_second)
+                           << " items/s";
+                    if (measured.bytes_per_second > 0)
+                        os << ", " << bench::format_si(measured.bytes_per_second)
+                           << "B/s";
+                    os << " [" << measured.samples.size() << " x "
+                       << measured.iterations << " iterations]";
+                    if (reference)
+                        os << (cmp.regression ? " REGRESSION" : "") << " vs baseline "
+                           << bench::format_ns(cmp.old_median_ns) << " ("
+                           << bench::format_change(cmp.change) << ", p = "
+                           << cmp.p_value << ")";
+                    os << "\n";
+                    if (!measured.perf.empty())
+                        os << "    perf: "
+                           << guard::perf::describe(
+                                  measured.perf,
+                                  static_cast<double>(measured.iterations) *
+                                      static_cast<double>(measured.samples.size()))
+                           << "\n";
+                    measurements.push_back(std::make_pair(&bm, std::move(measured)));
+                }
+                else
+                {
+                    ColorScope scope(os, Color::Red);
+                    os << "  \"" << bm.name << "\": failed\n";
+                }
+                tally.record(i, tc, std::move(result));
+            }
+        }
+
+        if (options.benchmark_out &&
+            !bench::save_results(options.benchmark_out, measurements))
+            os << "Cannot write benchmark results to \"" << options.benchmark_out
+               << "\"\n";
+
+        return detail::print_report(os, tally);
+    }
+
+    inline int run_all(const RunOptions &options, std::ostream &os = std::cout)
+    {
+        // Зерно свойств выбирается до запуска потоков раннера
+        guard::prop::detail::base_seed();
+
+        // Без доступа к счётчикам (контейнер, ВМ без PMU, запрет
+        // perf_event_paranoid) прогон идёт как без --perf-counters
+        guard::perf::enabled() = false;
+        if (options.perf_counters)
+        {
+            guard::perf::Group &group = guard::perf::thread_group();
+            if (!group.open())
+                os << "Performance counters are unavailable (" << group.error()
+                   << "), running without them\n";
+            else if (!group.error().empty())
+                os << "Some performance counters are unavailable (" << group.error()
+                   << ")\n";
+            guard::perf::enabled() = !guard::perf::thread_counts().empty();
+        }
+
+        if (options.benchmark)
+            return run_benchmarks(options, os);
+
+        // Сортируем тесты по файлу, строке и имени прямо в списке
+        // регистрации (без копии); повторный запуск сортировку не повторяет
+        auto &all = registry();
+        all.sort(detail::test_less);
+
+        // Выражения отбора разбираются один раз, проверка теста без выделений
+        const guard::detail::Selector selector = detail::make_selector(options);
+        std::vector<const TestCase *> tests;
+        tests.reserve(all.size());
+        for (const auto &tc : all)
+        {
+            if (selector.matches(tc.name, tc.file, tc.tags))
+                tests.push_back(&tc);
+        }
+
+        TimingDb timings;
+        if (options.timings_path && !timings.load(options.timings_path))
+            timings = TimingDb();
+
+        if (options.shard_count > 0)
+        {
+            if (options.shard_index >= options.shard_count)
+            {
+                os << "Invalid shard: --shard-index must be less than "
+                      "--shard-count\n";
+                return 2;
+            }
+
+            const std::size_t selected = tests.size();
+            detail::select_shard(tests, options.shard_index, options.shard_count, timings);
+            if (!options.list_tests)
+                os << "Shard " << options.shard_index << "/" << options.shard_count
+                   << ": running " << tests.size() << " of " << selected
+                   << " tests\n";
+        }
+
+        if (options.list_tests)
+        {
+            detail::list_tests(os, tests);
+            return 0;
+        }
+
+        detail::ReportSink sink;
+        for (const char *spec : options.reporters)
+        {
+            std::unique_ptr<report::Reporter> reporter = report::make_reporter(spec);
+            if (!reporter)
+            {
+                os << "Cannot open reporter \"" << spec
+                   << "\" (expected junit:path, jsonl:path or tap:path)\n";
+                return 2;
+            }
+            sink.add(std::move(reporter));
+        }
+        if (options.complexity_csv && !bench::start_complexity_csv(options.complexity_csv))
+        {
+            os << "Cannot write complexity measurements to \"" << options.complexity_csv
+               << "\"\n";
+            return 2;
+        }
+
+        std::size_t jobs = options.jobs;
+        if (jobs == 0)
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+        jobs = std::max<std::size_t>(1, std::min(jobs, tests.size()));
+
+        std::size_t fork_workers = options.fork_workers;
+#if !GUARD_TEST_FORK_SUPPORTED
+        if (fork_workers > 0)
+        {
+            os << "--fork-workers is not supported on this platform, "
+                  "running tests in-process\n";
+            fork_workers = 0;
+        }
+#endif
+        if (tests.empty())
+            fork_workers = 0;
+        if (fork_workers > 0)
+            jobs = 1;
+
+        // Сторож нужен, если задан общий предел или свой хотя бы у одного теста
+        bool watchdog = options.test_timeout_ms > 0;
+        for (std::size_t i = 0; !watchdog && i < tests.size(); ++i)
+            watchdog = tests[i]->timeout_ms > 0;
+
+        guard::detail::CaptureSettings &capture = guard::detail::capture_settings();
+        capture.mode = options.capture;
+        capture.limit = options.capture_limit;
+        if (capture.mode == guard::detail::CaptureMode::Fd)
+        {
+#if GUARD_TEST_FD_CAPTURE_SUPPORTED
+            // Дескрипторы общие на процесс: потоки не разделить, а поток,
+            // брошенный сторожем, писал бы в вывод следующих тестов
+            if (fork_workers == 0 && (jobs > 1 || watchdog))
+            {
+                os << "--capture=fd needs --fork-workers when running with "
+                      "--jobs or test timeouts, capturing std::cout only\n";
+                capture.mode = guard::detail::CaptureMode::Stream;
+            }
+#else
+            os << "--capture=fd is not supported on this platform, "
+                  "capturing std::cout only\n";
+            capture.mode = guard::detail::CaptureMode::Stream;
+#endif
+        }
+
+        // Параллельные прогоны стартуют с самых долгих тестов — так
+        // меньше хвост, когда все потоки кроме одного уже простаивают
+        const bool longest_first = !timings.empty() && (jobs > 1 || fork_workers > 1);
+        const std::vector<std::size_t> order =
+            detail::schedule(tests, longest_first ? &timings : nullptr);
+
+        std::vector<detail::RunTally> tallies(jobs);
+        for (auto &tally : tallies)
+        {
+            tally.collect_timings = options.timings_path && !options.timings_readonly;
+            tally.durations_limit = options.durations;
+            if (!sink.empty())
+            {
+                tally.sink = &sink;
+                tally.detail_limit = 100;
+            }
+        }
+        sink.begin(tests.size());
+        const auto run_start = std::chrono::steady_clock::now();
+        {
+            detail::CoutDispatch dispatch;
+            if (fork_workers > 0)
+            {
+#if GUARD_TEST_FORK_SUPPORTED
+                detail::run_forked(tests, order, fork_workers, tallies[0], os,
+                                   options.test_timeout_ms);
+#endif
+            }
+            else if (jobs == 1 && !watchdog)
+            {
+                for (std::size_t i = 0; i < tests.size(); ++i)
+                {
+                    const TestCase &tc = *tests[i];
+                    if (verbose())
+                        detail::announce(os, tc);
+                    tallies[0].record(i, tc, run_test(tc));
+                }
+            }
+            else
+            {
+                detail::run_parallel(tests, order, longest_first, tallies, os, watchdog,
+                                     options.test_timeout_ms);
+            }
+        }
+
+        detail::RunTally &total = tallies[0];
+        for (std::size_t t = 1; t < tallies.size(); ++t)
+            total.merge(std::move(tallies[t]));
+
+        report::Totals report_totals;
+        report_totals.tests = static_cast<unsigned long long>(total.stats.total);
+        report_totals.failed = static_cast<unsigned long long>(total.stats.failed);
+        report_totals.wall_us = std::chrono::duration<double, std::micro>(
+                                    std::chrono::steady_clock::now() - run_start)
+                                    .count();
+        sink.end(report_totals);
+
+        if (total.collect_timings)
+        {
+            for (const auto &sample : total.timings)
+                timings.update(*sample.tc, sample.wall_us, sample.cpu_us);
+            if (!timings.save(options.timings_path))
+                os << "Cannot write timings file \"" << options.timings_path
+                   << "\"\n";
+        }
+
+        // Порядок отчёта совпадает с последовательным прогоном
+        std::sort(total.failures.begin(),
+                  total.failures.end(),
+                  [](const TestSummary &lhs, const TestSummary &rhs) {
+                      return lhs.index < rhs.index;
+                  });
+
+        return detail::print_report(os, total);
+    }
+
+    // test_filter == nullptr -> запускать все тесты
+    inline int run_all(const char *test_filter, std::ostream &os = std::cout)
+    {
+        RunOptions options;
+        options.test_filter = test_filter;
+        return run_all(options, os);
+    }
+
+    inline int run_all(std::ostream &os = std::cout)
+    {
+        return run_all(nullptr, os);
+    }
+
+    namespace detail
+    {
+        // Значение опции в форме "--name=value" или "--name value"
+        inline bool option_value(int argc,
+                                 char **argv,
+                                 int &i,
+                                 const char *name,
+                                 const char *&value)
+        {
+            const char *arg = argv[i];
+            const std::size_t len = std::strlen(name);
+            if (std::strncmp(arg, name, len) != 0)
+                return false;
+            if (arg[len] == '=')
+            {
+                value = arg + len + 1;
+                return true;
+            }
+            if (arg[len] == '\0' && i + 1 < argc)
+            {
+                value = argv[++i];
+                return true;
+            }
+            return false;
+        }
+    } // namespace detail
+
+    inline void parse_args(int argc, char **argv, RunOptions &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *value = nullptr;
+            if (detail::option_value(argc, argv, i, "--test-case", value))
+            {
+                options.test_include.push_back(value);
+            }
+            else if (detail::option_value(argc, argv, i, "--test-case-exclude", value))
+            {
+                options.test_exclude.push_back(value);
+            }
+            else if (detail::option_value(argc, argv, i, "--source-file", value))
+            {
+                options.file_include.push_back(value);
+            }
+            else if (detail::option_value(argc, argv, i, "--source-file-exclude", value))
+            {
+                options.file_exclude.push_back(value);
+            }
+            else if (std::strcmp(argv[i], "--list-tests") == 0)
+            {
+                options.list_tests = true;
+            }
+            else if (detail::option_value(argc, argv, i, "--jobs", value))
+            {
+                options.jobs =
+                    static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--fork-workers", value))
+            {
+                options.fork_workers =
+                    static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--shard-index", value))
+            {
+                options.shard_index =
+                    static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--shard-count", value))
+            {
+                options.shard_count =
+                    static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--timings", value))
+            {
+                options.timings_path = value;
+            }
+            else if (std::strcmp(argv[i], "--timings-readonly") == 0)
+            {
+                options.timings_readonly = true;
+            }
+            else if (std::strcmp(argv[i], "--benchmark") == 0)
+            {
+                options.benchmark = true;
+            }
+            else if (detail::option_value(argc, argv, i, "--benchmark-min-time", value))
+            {
+                options.bench.min_time_ms = std::strtod(value, nullptr);
+            }
+            else if (detail::option_value(argc, argv, i, "--benchmark-warmup", value))
+            {
+                options.bench.warmup_ms = std::strtod(value, nullptr);
+            }
+            else if (detail::option_value(argc, argv, i, "--benchmark-repetitions", value))
+            {
+                options.bench.repetitions =
+                    static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--benchmark-out", value))
+            {
+                options.benchmark_out = value;
+            }
+            else if (detail::option_value(argc, argv, i, "--benchmark-baseline", value))
+            {
+                options.benchmark_baseline = value;
+            }
+            else if (detail::option_value(argc, argv, i, "--benchmark-alpha", value))
+            {
+                options.bench_compare.alpha = std::strtod(value, nullptr);
+            }
+            else if (detail::option_value(argc, argv, i, "--benchmark-threshold", value))
+            {
+                options.bench_compare.min_effect = std::strtod(value, nullptr) / 100;
+            }
+            else if (detail::option_value(argc, argv, i, "--fuzz-corpus", value))
+            {
+                guard::fuzz::corpus_root() = value;
+            }
+            else if (detail::option_value(argc, argv, i, "--seed", value))
+            {
+                guard::prop::settings().seed = std::strtoull(value, nullptr, 10);
+                guard::prop::settings().seed_set = true;
+            }
+            else if (detail::option_value(argc, argv, i, "--property-cases", value))
+            {
+                guard::prop::settings().cases =
+                    static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--diff-context", value))
+            {
+                guard::diff::settings().context = std::strtoul(value, nullptr, 10);
+            }
+            else if (std::strcmp(argv[i], "--perf-counters") == 0)
+            {
+                options.perf_counters = true;
+            }
+            else if (detail::option_value(argc, argv, i, "--complexity-csv", value))
+            {
+                options.complexity_csv = value;
+            }
+            else if (detail::option_value(argc, argv, i, "--test-timeout", value))
+            {
+                options.test_timeout_ms =
+                    static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--durations", value))
+            {
+                options.durations =
+                    static_cast<std::size_t>(std::strtoul(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--reporter", value))
+            {
+                options.reporters.push_back(value);
+            }
+            else if (detail::option_value(argc, argv, i, "--capture", value))
+            {
+                if (std::strcmp(value, "fd") == 0)
+                    options.capture = guard::detail::CaptureMode::Fd;
+                else if (std::strcmp(value, "none") == 0)
+                    options.capture = guard::detail::CaptureMode::None;
+                else
+                    options.capture = guard::detail::CaptureMode::Stream;
+            }
+            else if (detail::option_value(argc, argv, i, "--capture-limit", value))
+            {
+                options.capture_limit =
+                    static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+            }
+            else if (detail::option_value(argc, argv, i, "--max-failures", value))
+            {
+                guard_check_max_failures() =
+                    static_cast<std::size_t>(std::strtoul(value, nullptr, 10));
+            }
+            else if (std::strcmp(argv[i], "--verbose") == 0)
+            {
+                set_verbose(true);
+            }
+        }
+    }
+
+    inline int run_main(int argc, char **argv)
+    {
+        RunOptions options;
+        parse_args(argc, argv, options);
+        const int rc = run_all(options);
+        if (detail::abandoned_threads() > 0)
+        {
+            // Зависшие потоки ещё работают: обычный выход из main запустил
+            // бы деструкторы статиков под ними
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+            std::_Exit(rc);
+        }
+        return rc;
+    }
+} // namespace test
+} // namespace guard
+
+// ---------- внутренняя склейка имён ----------
+#define GUARD_TEST_CONCAT_IMPL(a, b) a##b
+#define GUARD_TEST_CONCAT(a, b) GUARD_TEST_CONCAT_IMPL(a, b)
+
+// ---------- PUBLIC API: TEST_CASE ----------
+//
+// TEST_CASE("name") {
+//     CHECK(...);
+// }
+#ifdef __COUNTER__
+#define GUARD_TEST_UNIQUE_ID __COUNTER__
+#else
+#define GUARD_TEST_UNIQUE_ID __LINE__
+#endif
+
+// Аргументы TEST_CASE ("name" и, необязательно, "[tags]") идут последними
+#define GUARD_TEST_CASE_TAGGED_IMPL(id, ...)                                   \
+    static void GUARD_TEST_CONCAT(guard_test_func_, id)();                     \
+    static ::guard::test::Registrar GUARD_TEST_CONCAT(guard_test_reg_, id)(    \
+        __FILE__,                                                              \
+        __LINE__,                                                              \
+        &GUARD_TEST_CONCAT(guard_test_func_, id),                              \
+        __VA_ARGS__);                                                          \
+    static void GUARD_TEST_CONCAT(guard_test_func_, id)()
+
+#define GUARD_TEST_CASE_IMPL(name, id) GUARD_TEST_CASE_TAGGED_IMPL(id, name)
+
+// TEST_CASE("name"), TEST_CASE("name", "[tag1][tag2]"); последним
+// аргументом можно задать предел времени: guard::test::timeout_ms(500)
+#define TEST_CASE(...) GUARD_TEST_CASE_TAGGED_IMPL(GUARD_TEST_UNIQUE_ID, __VA_ARGS__)
+
+// ---------- PUBLIC API: TEST_CASE_FIXTURE ----------
+//
+// struct Db { Db() { open(); } ~Db() { close(); } Connection conn; };
+//
+// TEST_CASE_FIXTURE(Db, "insert", "[db]") {
+//     CHECK(conn.insert(1));
+// }
+//
+// Тело — метод наследника фикстуры: члены доступны напрямую. Фикстура
+// строится заново для каждого запуска теста (конструктор — подготовка,
+// деструктор — уборка, в том числе после провала REQUIRE)
+#define GUARD_TEST_CASE_FIXTURE_IMPL(id, fixture, ...)                         \
+    namespace                                                                  \
+    {                                                                          \
+        struct GUARD_TEST_CONCAT(guard_fixture_test_, id) : fixture            \
+        {                                                                      \
+            void guard_test_body();                                            \
+        };                                                                     \
+    }                                                                          \
+    static void GUARD_TEST_CONCAT(guard_test_func_, id)()                      \
+    {                                                                          \
+        GUARD_TEST_CONCAT(guard_fixture_test_, id) guard_fixture;              \
+        guard_fixture.guard_test_body();                                       \
+    }                                                                          \
+    static ::guard::test::Registrar GUARD_TEST_CONCAT(guard_test_reg_, id)(    \
+        __FILE__,                                                              \
+        __LINE__,                                                              \
+        &GUARD_TEST_CONCAT(guard_test_func_, id),                              \
+        __VA_ARGS__);                                                          \
+    void GUARD_TEST_CONCAT(guard_fixture_test_, id)::guard_test_body()
+
+// TEST_CASE_FIXTURE(Fixture, "name"), дальше — как у TEST_CASE
+#define TEST_CASE_FIXTURE(fixture, ...)                                        \
+    GUARD_TEST_CASE_FIXTURE_IMPL(GUARD_TEST_UNIQUE_ID, fixture, __VA_ARGS__)
+
+// Общая фикстура (guard::fixture): строится при первом обращении,
+// доступна всем тестам только для чтения, уничтожается при выходе.
+//
+// GUARD_SHARED_FIXTURE(BigIndex, index);
+// TEST_CASE("lookup") { CHECK(index->find(42)); }
+#define GUARD_SHARED_FIXTURE(type, name)                                       \
+    static ::guard::fixture::SharedFixture<type> name(#name, __FILE__, __LINE__)
+
+// ---------- PUBLIC API: BENCHMARK ----------
+//
+// BENCHMARK("name") {
+//     while (state.keep_running())
+//         guard::do_not_optimize(work());
+// }
+#define GUARD_BENCHMARK_IMPL(name, id)                                         \
+    static void GUARD_TEST_CONCAT(guard_bench_func_, id)(                      \
+        ::guard::bench::State &);                                              \
+    static ::guard::bench::Registrar GUARD_TEST_CONCAT(guard_bench_reg_, id)(  \
+        name,                                                                  \
+        __FILE__,                                                              \
+        __LINE__,                                                              \
+        &GUARD_TEST_CONCAT(guard_bench_func_, id));                            \
+    static void GUARD_TEST_CONCAT(guard_bench_func_, id)(                      \
+        ::guard::bench::State & state)
+
+#define BENCHMARK(name) GUARD_BENCHMARK_IMPL(name, GUARD_TEST_UNIQUE_ID)
+
+// ---------- PUBLIC API: PROPERTY ----------
+//
+// PROPERTY("reverse twice", guard::prop::gen::vectors(guard::prop::gen::integers<int>()))
+// (const std::vector<int> &v) {
+//     CHECK_EQ(reversed(reversed(v)), v);
+// }
+//
+// Тело — функция, объявленная заранее по типам значений генераторов,
+// поэтому параметры должны быть ровно const T & в порядке генераторов
+// (иначе компоновщик не найдёт guard_prop_body_N)
+#define GUARD_PROPERTY_IMPL(id, name, ...)                                     \
+    static auto GUARD_TEST_CONCAT(guard_prop_gens_, id) =                      \
+        ::std::make_tuple(__VA_ARGS__);                                        \
+    static ::guard::prop::detail::signature_of<decltype(                       \
+        GUARD_TEST_CONCAT(guard_prop_gens_, id))>::type                        \
+        GUARD_TEST_CONCAT(guard_prop_body_, id);                               \
+    static void GUARD_TEST_CONCAT(guard_test_func_, id)()                      \
+    {                                                                          \
+        ::guard::prop::check(name,                                             \
+                             GUARD_TEST_CONCAT(guard_prop_gens_, id),          \
+                             &GUARD_TEST_CONCAT(guard_prop_body_, id));        \
+    }                                                                          \
+    static ::guard::test::Registrar GUARD_TEST_CONCAT(guard_test_reg_, id)(    \
+        __FILE__, __LINE__, &GUARD_TEST_CONCAT(guard_test_func_, id), name);   \
+    static void GUARD_TEST_CONCAT(guard_prop_body_, id)
+
+#define PROPERTY(name, ...)                                                    \
+    GUARD_PROPERTY_IMPL(GUARD_TEST_UNIQUE_ID, name, __VA_ARGS__)
+
+// ---------- PUBLIC API: FUZZ_TEST ----------
+//
+// FUZZ_TEST("json parser", const std::uint8_t *data, std::size_t size) {
+//     CHECK(parse(data, size).valid() || ...);
+// }
+//
+// В обычном прогоне — тест с меткой [fuzz] по корпусу цели (guard::fuzz),
+// со сборкой -DGUARD_TEST_FUZZING — цель libFuzzer
+#define GUARD_FUZZ_TEST_IMPL(id, name, ...)                                    \
+    static void GUARD_TEST_CONCAT(guard_fuzz_body_, id)(__VA_ARGS__);          \
+    static ::guard::fuzz::Registrar GUARD_TEST_CONCAT(guard_fuzz_reg_, id)(    \
+        __FILE__, __LINE__, &GUARD_TEST_CONCAT(guard_fuzz_body_, id), name);   \
+    static void GUARD_TEST_CONCAT(guard_test_func_, id)()                      \
+    {                                                                          \
+        ::guard::fuzz::replay(GUARD_TEST_CONCAT(guard_fuzz_reg_, id).node);    \
+    }                                                                          \
+    static ::guard::test::Registrar GUARD_TEST_CONCAT(guard_test_reg_, id)(    \
+        __FILE__, __LINE__, &GUARD_TEST_CONCAT(guard_test_func_, id), name,    \
+        "[fuzz]");                                                             \
+    static void GUARD_TEST_CONCAT(guard_fuzz_body_, id)(__VA_ARGS__)
+
+#define FUZZ_TEST(name, ...)                                                   \
+    GUARD_FUZZ_TEST_IMPL(GUARD_TEST_UNIQUE_ID, name, __VA_ARGS__)
+
+// ---------- Алисы CHECK* / REQUIRE* на GUARD_* ----------
+
+#ifndef GUARD_TEST_NO_CHECK_ALIASES
+#define CHECK(...) GUARD_CHECK(__VA_ARGS__)
+#define CHECK_FALSE(expr) GUARD_CHECK_FALSE(expr)
+#define CHECK_EQ(a, b) GUARD_CHECK_EQ(a, b)
+#define CHECK_NEQ(a, b) GUARD_CHECK_NEQ(a, b)
+#define CHECK_LT(a, b) GUARD_CHECK_LT(a, b)
+#define CHECK_GT(a, b) GUARD_CHECK_GT(a, b)
+
+#define REQUIRE(...) GUARD_REQUIRE(__VA_ARGS__)
+#define REQUIRE_FALSE(expr) GUARD_REQUIRE_FALSE(expr)
+#define REQUIRE_EQ(a, b) GUARD_REQUIRE_EQ(a, b)
+#define REQUIRE_NEQ(a, b) GUARD_REQUIRE_NEQ(a, b)
+#define REQUIRE_LT(a, b) GUARD_REQUIRE_LT(a, b)
+#define REQUIRE_GT(a, b) GUARD_REQUIRE_GT(a, b)
+#define FAIL(msg) GUARD_TEST_FAIL_MSG(msg)
 #endif
 
 // ---------- общий helper для "сделать фейл" ----------
 #define GUARD_TEST_FAIL_MSG(msg_)                                              \
-    do                                                                         \
-    {                                                                          \
-        GUARD_CHECK_ENV_COUNT_ASSERT(false);                                   \
-        std::string _guard_msg = std::string("Test assertion failed at ") +    \
-                                 __FILE__ + ":" + ::guard::detail::to_string(__LINE__) + \
-                                 ": " + (msg_);                                \
-        GUARD_CHECK_ENV_APPEND(_guard_msg);                                    \
-        GUARD_CHECK_ENV_RAISE_IMPL();                                          \
-    } while (0)
+    ::guard::test::detail::fail_at(__FILE__, __LINE__, (msg_))
 
 // ---------- проверки исключений ----------
 
@@ -494,6 +2862,173 @@ namespace test
         GUARD_CHECK_ENV_COUNT_ASSERT(true);                                    \
     } while (0)
 
+// ---------- относительная скорость ----------
+// fast_code быстрее slow_code не меньше чем в min_ratio раз (мягкий).
+// Оба участка выполняются партиями попеременно, проверка проходит, если
+// нижняя граница 95% доверительного интервала отношения не ниже
+// min_ratio (см. guard::bench::compare_speed). Код с запятыми нужно
+// заключить в скобки: CHECK_FASTER_THAN((f(a, b)), (g(a, b)), 2)
+#define CHECK_FASTER_THAN(fast_code, slow_code, min_ratio)                     \
+    do                                                                         \
+    {                                                                          \
+        const double _guard_min_ratio = static_cast<double>(min_ratio);        \
+        const ::guard::bench::SpeedRatio _guard_speed =                        \
+            ::guard::bench::compare_speed([&]() { fast_code; },                \
+                                          [&]() { slow_code; },                \
+                                          _guard_min_ratio);                   \
+        const bool _guard_ok = _guard_speed.lower >= _guard_min_ratio;         \
+        GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
+        {                                                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(loc,                                     \
+                                      "speedup of " #fast_code                 \
+                                      " over " #slow_code " >= " #min_ratio,   \
+                                      ::guard::bench::describe(_guard_speed),  \
+                                      _guard_min_ratio,                        \
+                                      false);                                  \
+        }                                                                      \
+    } while (0)
+
+// ---------- массовые сравнения чисел ----------
+// Массивы float или double (контейнер с data()/size(), встроенный массив
+// или guard::bulk::span(ptr, n)) сравниваются поэлементно векторным
+// циклом (guard::bulk). Проверка одна на весь массив (мягкая); при
+// провале в отчёте число несовпадений, наибольшая ошибка с индексом и
+// первые несовпавшие элементы.
+#define GUARD_TEST_ALL_NUMBERS_IMPL(compare, limit, limit_text, unit, cond, actual, expected) \
+    do                                                                         \
+    {                                                                          \
+        const auto &_guard_actual = (actual);                                  \
+        const auto &_guard_expected = (expected);                              \
+        const auto _guard_a = ::guard::bulk::detail::as_span(_guard_actual);   \
+        const auto _guard_b = ::guard::bulk::detail::as_span(_guard_expected); \
+        const ::guard::bulk::Mismatches _guard_m =                             \
+            ::guard::bulk::compare(_guard_a, _guard_b, limit);                 \
+        GUARD_CHECK_ENV_COUNT_ASSERT(_guard_m.ok());                           \
+        if (GUARD_UNLIKELY(!_guard_m.ok()))                                    \
+        {                                                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, cond,                                                     \
+                ::guard::bulk::describe(_guard_m, _guard_a, _guard_b, unit),   \
+                limit_text, false);                                            \
+        }                                                                      \
+    } while (0)
+
+// |actual[i] - expected[i]| <= epsilon * (scale + |expected[i]|);
+// tolerance — epsilon или guard::Approx(0).epsilon(e).scale(s)
+#define CHECK_ALL_APPROX(actual, expected, tolerance)                          \
+    GUARD_TEST_ALL_NUMBERS_IMPL(                                               \
+        approx_all, ::guard::bulk::Tolerance(tolerance),                       \
+        ::guard::bulk::describe(::guard::bulk::Tolerance(tolerance)), "",      \
+        "all " #actual " == Approx(" #expected ")", actual, expected)
+
+// actual[i] и expected[i] отстоят не больше чем на max_ulps
+// представимых чисел; +0 и -0 совпадают, NaN не совпадает ни с чем
+#define CHECK_ALL_ULP(actual, expected, max_ulps)                              \
+    GUARD_TEST_ALL_NUMBERS_IMPL(                                               \
+        ulp_all, static_cast<std::uint64_t>(max_ulps),                         \
+        std::to_string(static_cast<unsigned long long>(max_ulps)) + " ULP",    \
+        " ULP", "all " #actual " within " #max_ulps " ULP of " #expected,      \
+        actual, expected)
+
+// ---------- диапазоны и буферы ----------
+// Поэлементное равенство двух диапазонов (мягкий, одна проверка). Для
+// непрерывных диапазонов целых, перечислений и указателей — memcmp по
+// блокам. В отчёте окна вокруг первых несовпадений (guard::range)
+#define CHECK_RANGE_EQ(a, b)                                                   \
+    do                                                                         \
+    {                                                                          \
+        const auto &_guard_a = (a);                                            \
+        const auto &_guard_b = (b);                                            \
+        const ::guard::range::Mismatches _guard_m =                            \
+            ::guard::range::compare(_guard_a, _guard_b);                       \
+        GUARD_CHECK_ENV_COUNT_ASSERT(_guard_m.ok());                           \
+        if (GUARD_UNLIKELY(!_guard_m.ok()))                                    \
+        {                                                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, "all of " #a " == " #b,                                   \
+                ::guard::range::describe(_guard_m, _guard_a, _guard_b),        \
+                "equal ranges", false);                                        \
+        }                                                                      \
+    } while (0)
+
+// Равенство len байт по двум адресам (мягкий); провал — hexdump строк
+// с первыми отличиями
+#define CHECK_MEM_EQ(a, b, len)                                                \
+    do                                                                         \
+    {                                                                          \
+        const void *_guard_a = (a);                                            \
+        const void *_guard_b = (b);                                            \
+        const ::guard::range::Mismatches _guard_m =                            \
+            ::guard::range::compare_bytes(_guard_a, _guard_b,                  \
+                                          static_cast<std::size_t>(len));      \
+        GUARD_CHECK_ENV_COUNT_ASSERT(_guard_m.ok());                           \
+        if (GUARD_UNLIKELY(!_guard_m.ok()))                                    \
+        {                                                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, "memory at " #a " == " #b " (" #len " bytes)",            \
+                ::guard::range::describe_bytes(_guard_m, _guard_a, _guard_b),  \
+                "equal bytes", false);                                         \
+        }                                                                      \
+    } while (0)
+
+// pred(x) для каждого элемента (мягкий). Каждый элемент — отдельная
+// проверка в счётчиках, но счётчики обновляются один раз на диапазон;
+// провал перечисляет первые неподходящие элементы
+#define CHECK_ALL_OF(values, ...)                                              \
+    do                                                                         \
+    {                                                                          \
+        const ::guard::range::Violations _guard_v =                            \
+            ::guard::range::all_of((values), __VA_ARGS__);                      \
+        GUARD_CHECK_ENV_COUNT_ASSERTS(_guard_v.size, _guard_v.count);          \
+        if (GUARD_UNLIKELY(_guard_v.count > 0))                                \
+        {                                                                      \
+            GUARD_STATIC_LOCATION(loc);                                        \
+            guard_check_report_binary(                                         \
+                loc, "all of " #values " satisfy " GUARD_STRINGIFY(__VA_ARGS__),\
+                ::guard::range::describe(_guard_v), "all elements", false);    \
+        }                                                                      \
+    } while (0)
+
+// ---------- эмпирическая сложность ----------
+// Код выполняется при n = first, 2 * first, ... <= last (n — имя
+// переменной типа std::size_t, видимой в коде), время каждого размера
+// аппроксимируется классами O(1) ... O(n^3). Проверка (мягкая) проходит,
+// если выбранный класс не сложнее bound: o1, oLogN, oN, oNLogN, oN2, oN3.
+// Код идёт последним и может содержать запятые:
+//   CHECK_COMPLEXITY(oN, n, 64, 1 << 16, std::sort(v.begin(), v.begin() + n))
+// С --complexity-csv=path замеры каждого размера дописываются в файл.
+#define CHECK_COMPLEXITY(bound, n, first, last, ...)                          \
+    do                                                                         \
+    {                                                                          \
+        ::guard::bench::ComplexityConfig _guard_config;                        \
+        _guard_config.min_n = static_cast<std::size_t>(first);                 \
+        _guard_config.max_n = static_cast<std::size_t>(last);                  \
+        const ::guard::bench::ComplexityResult _guard_result =                 \
+            ::guard::bench::measure_complexity(                                \
+                [&](std::size_t n) { __VA_ARGS__; }, _guard_config);           \
+        GUARD_STATIC_LOCATION(loc);                                            \
+        ::guard::bench::append_complexity_csv(                                 \
+            loc.file, loc.line, GUARD_STRINGIFY(__VA_ARGS__), _guard_result);  \
+        const bool _guard_ok = _guard_result.best_fit().complexity <=          \
+                               ::guard::bench::Complexity::bound;              \
+        GUARD_CHECK_ENV_COUNT_ASSERT(_guard_ok);                               \
+        if (GUARD_UNLIKELY(!_guard_ok))                                        \
+        {                                                                      \
+            guard_check_report_binary(                                         \
+                loc,                                                           \
+                "complexity of " GUARD_STRINGIFY(__VA_ARGS__) " <= " #bound,   \
+                ::guard::bench::describe(_guard_result),                       \
+                ::guard::bench::complexity_name(                               \
+                    ::guard::bench::Complexity::bound),                        \
+                false);                                                        \
+        }                                                                      \
+    } while (0)
+
 // ---------- "таймаут" по времени выполнения ----------
 #define CHECK_TIMEOUT(code, ms)                                                \
     do                                                                         \
@@ -518,30 +3053,158 @@ namespace test
         }                                                                      \
     } while (0)
 
+// ---------- выделения памяти ----------
+// Требуют подсчёта выделений (GUARD_TEST_ALLOC_HOOKS); без него проваливаются,
+// чтобы не давать ложной уверенности. Учитываются выделения текущего потока.
+
+// Код передаётся последним аргументом, чтобы запятые внутри него
+// (например, из развёрнутого CHECK_EQ) не ломали вызов
+#define GUARD_TEST_MAX_ALLOCS_IMPL(n, ...)                                     \
+    do                                                                         \
+    {                                                                          \
+        unsigned long long _guard_allocs = 0;                                  \
+        unsigned long long _guard_alloc_bytes = 0;                             \
+        {                                                                      \
+            ::guard::alloc::Scope _guard_scope;                                \
+            __VA_ARGS__;                                                       \
+            _guard_allocs = _guard_scope.count();                              \
+            _guard_alloc_bytes = _guard_scope.bytes();                         \
+        }                                                                      \
+        if (!::guard::alloc::enabled())                                        \
+        {                                                                      \
+            GUARD_TEST_FAIL_MSG(                                               \
+                std::string("Allocation tracking is disabled, define "         \
+                            "GUARD_TEST_ALLOC_HOOKS to check: ") +             \
+                #__VA_ARGS__);                                                 \
+        }                                                                      \
+        else if (_guard_allocs > static_cast<unsigned long long>(n))           \
+        {                                                                      \
+            GUARD_TEST_FAIL_MSG(                                               \
+                std::string("Too many allocations: expression ") +             \
+                #__VA_ARGS__ + " made " +                                      \
+                ::guard::detail::to_string(_guard_allocs) +                    \
+                " allocations (" +                                             \
+                ::guard::detail::to_string(_guard_alloc_bytes) +               \
+                " bytes), limit is " + ::guard::detail::to_string(n));         \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            GUARD_CHECK_ENV_COUNT_ASSERT(true);                                \
+        }                                                                      \
+    } while (0)
+
+// code делает не больше n выделений памяти (фатальный)
+#define CHECK_MAX_ALLOCS(code, n) GUARD_TEST_MAX_ALLOCS_IMPL(n, code)
+
+// code не выделяет память (фатальный)
+#define CHECK_NO_ALLOC(...) GUARD_TEST_MAX_ALLOCS_IMPL(0, __VA_ARGS__)
+
+// ---------- аппаратные счётчики ----------
+// Промахи на операцию (фатальные): code выполняет ops операций, событие
+// считается аппаратным счётчиком потока (guard::perf). Если счётчик
+// недоступен, проверка пропускается с одним предупреждением на процесс.
+#define GUARD_TEST_MAX_PER_OP_IMPL(event, ops, max, ...)                       \
+    do                                                                         \
+    {                                                                          \
+        const ::guard::perf::Counts _guard_perf_start =                        \
+            ::guard::perf::thread_counts();                                    \
+        __VA_ARGS__;                                                           \
+        const ::guard::perf::Counts _guard_perf =                              \
+            ::guard::perf::thread_counts() - _guard_perf_start;                \
+        const double _guard_ops = static_cast<double>(ops);                    \
+        const double _guard_per_op = _guard_perf.per_op(event, _guard_ops);    \
+        if (!_guard_perf.has(event))                                           \
+        {                                                                      \
+            ::guard::perf::detail::note_unavailable(event);                    \
+            GUARD_CHECK_ENV_COUNT_ASSERT(true);                                \
+        }                                                                      \
+        else if (_guard_per_op > static_cast<double>(max))                     \
+        {                                                                      \
+            GUARD_TEST_FAIL_MSG(                                               \
+                std::string("Too many ") + ::guard::perf::event_name(event) +  \
+                ": expression " #__VA_ARGS__ " made " +                        \
+                ::guard::detail::to_string(_guard_per_op) + " per op (" +      \
+                ::guard::perf::describe(_guard_perf, _guard_ops) +             \
+                "), limit is " + ::guard::detail::to_string(max));             \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            GUARD_CHECK_ENV_COUNT_ASSERT(true);                                \
+        }                                                                      \
+    } while (0)
+
+// Промахи кэша последнего уровня на операцию
+#define CHECK_MAX_CACHE_MISSES_PER_OP(code, ops, max)                          \
+    GUARD_TEST_MAX_PER_OP_IMPL(::guard::perf::LlcMisses, ops, max, code)
+
+// Промахи кэша данных L1 на операцию
+#define CHECK_MAX_L1D_MISSES_PER_OP(code, ops, max)                            \
+    GUARD_TEST_MAX_PER_OP_IMPL(::guard::perf::L1dMisses, ops, max, code)
+
+// Промахи предсказания переходов на операцию
+#define CHECK_MAX_BRANCH_MISSES_PER_OP(code, ops, max)                         \
+    GUARD_TEST_MAX_PER_OP_IMPL(::guard::perf::BranchMisses, ops, max, code)
+
 // ---------- удобный main ----------
-// Поддержка фильтрации тестов по имени через аргумент командной строки:
-//   --test-case=NameSubstring
-//   --test-case NameSubstring
+// Аргументы командной строки:
+//   --test-case=PATTERNS | --test-case PATTERNS — отбор по имени или меткам:
+//     шаблоны через запятую; подстрока, glob с '*'/'?', "=точное имя",
+//     "[tag]"; флаг можно повторять
+//   --test-case-exclude=PATTERNS — исключить тесты
+//   --source-file=PATTERNS, --source-file-exclude=PATTERNS — то же по файлу
+//   --list-tests — напечатать выбранные тесты (имя, файл:строка, метки)
+//   --jobs=N | --jobs N — число потоков раннера (0 — по числу ядер)
+//   --fork-workers=N — изолировать тесты в N рабочих процессах (POSIX)
+//   --shard-index=I --shard-count=N — запустить только I-й шард из N
+//   --timings=path — база длительностей тестов (обновляется после прогона)
+//   --timings-readonly — только читать базу длительностей
+//   --benchmark — запустить BENCHMARK вместо тестов
+//   --benchmark-min-time=ms, --benchmark-warmup=ms, --benchmark-repetitions=N
+//   --benchmark-out=file.json — сохранить замеры
+//   --benchmark-baseline=file.json — сравнить с эталоном (регрессия = провал)
+//   --benchmark-alpha=p, --benchmark-threshold=pct — параметры сравнения
+//   --fuzz-corpus=DIR — корни корпусов FUZZ_TEST (по умолчанию
+//     fuzz_corpus): входы цели берутся из DIR/<имя цели>
+//   --seed=N — зерно PROPERTY (печатается при найденном контрпримере)
+//   --property-cases=N — случаев на свойство (по умолчанию 100)
+//   --diff-context=N — строк контекста в диффе длинных строк CHECK_EQ
+//     (по умолчанию 3)
+//   --perf-counters — аппаратные счётчики (IPC, промахи кэшей и
+//     предсказания переходов) на каждый тест и бенчмарк (Linux)
+//   --complexity-csv=path — замеры CHECK_COMPLEXITY по размерам (CSV)
+//   --max-failures=N — хранить не больше N мягких провалов на тест
+//     (по умолчанию 100, 0 — без ограничения), остальные только считать
+//   --test-timeout=ms — предел времени одного теста: зависший тест
+//     засчитывается проваленным, прогон продолжается (см. также
+//     TEST_CASE("name", guard::test::timeout_ms(ms)))
+//   --durations=N — напечатать N самых долгих тестов (время, CPU,
+//     переключения контекста, страничные ошибки)
+//   --reporter=junit:path | jsonl:path | tap:path — потоковый отчёт в файл
+//     (запись на каждый тест сразу после завершения); флаг можно повторять
+//   --capture=stream|fd|none — перехват вывода тестов: std::cout (по
+//     умолчанию), дескрипторы stdout и stderr (POSIX) или без перехвата
+//   --capture-limit=BYTES — хвост вывода проваленного теста (по умолчанию
+//     65536, 0 — весь вывод)
+//   --verbose — печатать имя каждого запускаемого теста
+//
+// Со сборкой -fsanitize=fuzzer -DGUARD_TEST_FUZZING вместо main
+// определяются точки входа libFuzzer для целей FUZZ_TEST; цель
+// выбирается флагом --fuzz-target=NAME или переменной GUARD_FUZZ_TARGET
+#if defined(GUARD_TEST_FUZZING)
+#define GUARD_TEST_MAIN()                                                      \
+    extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)               \
+    {                                                                          \
+        return ::guard::fuzz::initialize(argc, argv);                          \
+    }                                                                          \
+    extern "C" int LLVMFuzzerTestOneInput(const ::std::uint8_t *data,          \
+                                          ::std::size_t size)                  \
+    {                                                                          \
+        return ::guard::fuzz::test_one_input(data, size);                      \
+    }
+#else
 #define GUARD_TEST_MAIN()                                                      \
     int main(int argc, char **argv)                                            \
     {                                                                          \
-        const char *test_filter = nullptr;                                     \
-        for (int i = 1; i < argc; ++i)                                         \
-        {                                                                      \
-            const char *arg = argv[i];                                         \
-            const char prefix[] = "--test-case=";                              \
-            if (std::strncmp(arg, prefix, sizeof(prefix) - 1) == 0)            \
-            {                                                                  \
-                test_filter = arg + sizeof(prefix) - 1;                        \
-            }                                                                  \
-            else if (std::strcmp(arg, "--test-case") == 0 && i + 1 < argc)     \
-            {                                                                  \
-                test_filter = argv[++i];                                       \
-            }                                                                  \
-            else if (std::strcmp(arg, "--verbose") == 0)                       \
-            {                                                                  \
-                ::guard::test::set_verbose(true);                              \
-            }                                                                  \
-        }                                                                      \
-        return ::guard::test::run_all(test_filter);                            \
+        return ::guard::test::run_main(argc, argv);                            \
     }
+#endif
@@ -10,4 +10,8 @@ struct guard_location
 #define GUARD_CURRENT_LOCATION(name)                                           \
     struct guard_location name = {__LINE__, __FILE__, __func__};
 
+// То же, но в статической памяти: на месте вызова остаётся только адрес
+#define GUARD_STATIC_LOCATION(name)                                            \
+    static const struct guard_location name = {__LINE__, __FILE__, __func__};
+
 #define GUARD_CURRENT_LOCATION_INITARGS __LINE__, __FILE__, __func__
\ No newline at end of file
@@ -1,3 +1,16 @@
 #pragma once
 
-#define GUARD_STRINGIFY(...) #__VA_ARGS__
\ No newline at end of file
+#define GUARD_STRINGIFY(...) #__VA_ARGS__
+
+// Холодный путь: функция не встраивается и выносится из горячего кода
+// (отчёт о провале проверки)
+#if defined(__GNUC__) || defined(__clang__)
+#define GUARD_COLD __attribute__((cold, noinline))
+#define GUARD_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#elif defined(_MSC_VER)
+#define GUARD_COLD __declspec(noinline)
+#define GUARD_UNLIKELY(x) (x)
+#else
+#define GUARD_COLD
+#define GUARD_UNLIKELY(x) (x)
+#endif
\ No newline at end of file
@@ -5,7 +5,7 @@ param(
 # Шапка файла с include-guard'ом
 $header = @"
 // This file is auto-generated by make_one_header.ps1
-// Contains: macro.h, location.h, env.h, util.h, check.h, guard_main.h
+// Contains: macro.h, location.h, env.h, util.h, diff.h, check.h, registry.h, select.h, alloc.h, perf.h, bench.h, bulk.h, range.h, reporter.h, capture.h, property.h, fuzz.h, fixture.h, guard_main.h
 
 #ifndef GUARD_SINGLE_HEADER_HPP
 #define GUARD_SINGLE_HEADER_HPP
@@ -20,7 +20,20 @@ $files = @(
     "location.h",
     "env.h",
     "util.h",
+    "diff.h",
     "check.h",
+    "registry.h",
+    "select.h",
+    "alloc.h",
+    "perf.h",
+    "bench.h",
+    "bulk.h",
+    "range.h",
+    "reporter.h",
+    "capture.h",
+    "property.h",
+    "fuzz.h",
+    "fixture.h",
     "guard_main.h"
 )
 
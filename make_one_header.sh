@@ -11,7 +11,7 @@ cat > "$OUT" <<'EOF'
 #define GUARD_SINGLE_HEADER_HPP
 
 // Single-file amalgamated header generated by make_one_header.sh
-// Contains: macro.h, location.h, env.h, util.h, check.h, guard_main.h
+// Contains: macro.h, location.h, env.h, util.h, diff.h, check.h, registry.h, select.h, alloc.h, perf.h, bench.h, bulk.h, range.h, reporter.h, capture.h, property.h, fuzz.h, fixture.h, guard_main.h
 
 EOF
 
@@ -21,7 +21,20 @@ FILES=(
   "location.h"
   "env.h"
   "util.h"
+  "diff.h"
   "check.h"
+  "registry.h"
+  "select.h"
+  "alloc.h"
+  "perf.h"
+  "bench.h"
+  "bulk.h"
+  "range.h"
+  "reporter.h"
+  "capture.h"
+  "property.h"
+  "fuzz.h"
+  "fixture.h"
   "guard_main.h"
 )
 
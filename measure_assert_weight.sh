@@ -0,0 +1,85 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Замер "веса" макросов проверок: генерирует единицу трансляции с N тысячами
+# проверок, компилирует её и печатает время компиляции, размер объектного
+# файла и время выполнения одной проходящей проверки.
+#
+#   ./measure_assert_weight.sh [тысяч проверок, по умолчанию 10]
+#
+# Переменные окружения: CXX (по умолчанию c++), CXXFLAGS (по умолчанию
+# -std=c++11 -O2), GUARD_DIR (каталог с заголовками, по умолчанию каталог
+# скрипта), REPEAT (сколько раз прогнать каждую проверку, по умолчанию 1000).
+
+THOUSANDS=${1:-10}
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--std=c++11 -O2}
+GUARD_DIR=${GUARD_DIR:-$(cd "$(dirname "$0")" && pwd)}
+REPEAT=${REPEAT:-1000}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+ASSERTS=$((THOUSANDS * 1000))
+
+# Тесты по 1000 проверок; виды проверок чередуются, операнды берутся
+# из volatile, чтобы компилятор не свернул сравнения
+{
+    echo '#include "guard_main.h"'
+    echo 'static volatile int guard_weight_values[4] = {1, 2, 3, 4};'
+    for ((t = 0; t < THOUSANDS; ++t)); do
+        echo "TEST_CASE(\"weight $t\")"
+        echo "{"
+        echo "    for (int r = 0; r < $REPEAT; ++r)"
+        echo "    {"
+        echo "        const int a = guard_weight_values[0] + r * 0;"
+        echo "        const int b = guard_weight_values[1];"
+        for ((i = 0; i < 1000; i += 4)); do
+            echo "        CHECK(a != b);"
+            echo "        CHECK_EQ(a + $i, $i + 1);"
+            echo "        CHECK_LT(a, b + $i);"
+            echo "        REQUIRE_NEQ(a, b);"
+        done
+        echo "    }"
+        echo "}"
+    done
+} > "$WORK/weight.cpp"
+printf '#include "guard_main.h"\nGUARD_TEST_MAIN()\n' > "$WORK/main.cpp"
+
+now()
+{
+    date +%s.%N
+}
+
+# calc FORMAT EXPR — арифметика с плавающей точкой через awk
+calc()
+{
+    awk "BEGIN { printf \"$1\", $2 }"
+}
+
+START=$(now)
+# shellcheck disable=SC2086
+$CXX $CXXFLAGS -I"$GUARD_DIR" -c "$WORK/weight.cpp" -o "$WORK/weight.o"
+COMPILE=$(calc "%.2f" "$(now) - $START")
+
+# shellcheck disable=SC2086
+$CXX $CXXFLAGS -I"$GUARD_DIR" -c "$WORK/main.cpp" -o "$WORK/main.o"
+# shellcheck disable=SC2086
+$CXX $CXXFLAGS "$WORK/weight.o" "$WORK/main.o" -o "$WORK/weight" -pthread
+
+OBJ_BYTES=$(wc -c < "$WORK/weight.o")
+if command -v size > /dev/null; then
+    TEXT_BYTES=$(size "$WORK/weight.o" | awk 'NR == 2 { print $1 }')
+else
+    TEXT_BYTES=$OBJ_BYTES
+fi
+
+START=$(now)
+"$WORK/weight" > "$WORK/run.log" || { cat "$WORK/run.log"; exit 1; }
+RUN=$(calc "%.3f" "$(now) - $START")
+
+echo "Compiler      : $CXX $CXXFLAGS"
+echo "Asserts in TU : $ASSERTS"
+echo "Compile time  : ${COMPILE} s ($(calc "%.1f" "$COMPILE * 1000000 / $ASSERTS") us/assert)"
+echo "Object size   : $OBJ_BYTES bytes, .text $TEXT_BYTES ($(calc "%.1f" "$TEXT_BYTES / $ASSERTS") bytes/assert)"
+echo "Run time      : ${RUN} s ($(calc "%.2f" "$RUN * 1000000000 / ($ASSERTS * $REPEAT)") ns/assert)"
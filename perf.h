@@ -0,0 +1,356 @@
+// guard/perf.h
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Аппаратные счётчики производительности (Linux, perf_event_open).
+//
+// На поток открывается одна группа событий: такты, инструкции, промахи
+// L1D и последнего уровня кэша, промахи предсказания переходов. Группа
+// планируется ядром целиком, поэтому отношения (IPC, промахи на
+// инструкцию) согласованы даже при мультиплексировании счётчиков.
+// Считается только пользовательский режим: так хватает
+// perf_event_paranoid <= 2. В контейнерах и виртуальных машинах без PMU
+// события не открываются — тогда Counts пусты, а раннер работает как
+// без счётчиков.
+
+#if !defined(GUARD_TEST_PERF_SUPPORTED)
+#if defined(__linux__)
+#define GUARD_TEST_PERF_SUPPORTED 1
+#else
+#define GUARD_TEST_PERF_SUPPORTED 0
+#endif
+#endif
+
+#if GUARD_TEST_PERF_SUPPORTED
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace guard
+{
+    namespace perf
+    {
+        enum Event
+        {
+            Cycles,
+            Instructions,
+            L1dMisses,
+            LlcMisses,
+            BranchMisses,
+            EventCount
+        };
+
+        inline const char *event_name(Event event)
+        {
+            switch (event)
+            {
+            case Cycles:
+                return "cycles";
+            case Instructions:
+                return "instructions";
+            case L1dMisses:
+                return "L1D misses";
+            case LlcMisses:
+                return "LLC misses";
+            case BranchMisses:
+                return "branch misses";
+            case EventCount:
+                break;
+            }
+            return "?";
+        }
+
+        // Значения событий; available — маска событий, которые удалось
+        // открыть (бит 1 << Event). Пустые Counts — счётчиков нет
+        struct Counts
+        {
+            std::uint64_t value[EventCount] = {};
+            unsigned available = 0;
+
+            bool has(Event event) const
+            {
+                return (available & (1u << event)) != 0;
+            }
+
+            bool empty() const
+            {
+                return available == 0;
+            }
+
+            // Сумма по тестам: событие остаётся, только если оно есть у обоих
+            Counts &operator+=(const Counts &other)
+            {
+                if (other.empty())
+                    return *this;
+                available = empty() ? other.available : (available & other.available);
+                for (int e = 0; e < EventCount; ++e)
+                    value[e] += other.value[e];
+                return *this;
+            }
+
+            Counts operator-(const Counts &start) const
+            {
+                Counts d;
+                d.available = available & start.available;
+                for (int e = 0; e < EventCount; ++e)
+                    d.value[e] = value[e] >= start.value[e] ? value[e] - start.value[e] : 0;
+                return d;
+            }
+
+            // Событий на операцию; 0, если события нет
+            double per_op(Event event, double ops) const
+            {
+                return has(event) && ops > 0 ? static_cast<double>(value[event]) / ops : 0;
+            }
+
+            // Инструкций за такт; 0, если нет тактов или инструкций
+            double ipc() const
+            {
+                if (!has(Cycles) || !has(Instructions) || value[Cycles] == 0)
+                    return 0;
+                return static_cast<double>(value[Instructions]) /
+                       static_cast<double>(value[Cycles]);
+            }
+        };
+
+        // Снимать счётчики с каждого теста и бенчмарка (--perf-counters).
+        // Проверки CHECK_MAX_*_PER_OP открывают счётчики и без флага
+        inline bool &enabled()
+        {
+            static bool flag = false;
+            return flag;
+        }
+
+        // Группа событий текущего потока. Открывается при первом чтении;
+        // после fork дескрипторы родителя считают его поток, поэтому
+        // процесс-потомок открывает свою группу
+        class Group
+        {
+        public:
+            Group()
+            {
+                for (int e = 0; e < EventCount; ++e)
+                    m_fd[e] = -1;
+            }
+
+            Group(const Group &) = delete;
+            Group &operator=(const Group &) = delete;
+
+            ~Group()
+            {
+                close();
+            }
+
+            // false — ни одно событие не открылось (см. error())
+            bool open()
+            {
+#if GUARD_TEST_PERF_SUPPORTED
+                if (m_owner == ::getpid())
+                    return m_available != 0;
+                close();
+                m_owner = ::getpid();
+                for (int e = 0; e < EventCount; ++e)
+                {
+                    struct perf_event_attr attr;
+                    std::memset(&attr, 0, sizeof(attr));
+                    attr.size = sizeof(attr);
+                    describe(static_cast<Event>(e), attr);
+                    attr.exclude_kernel = 1;
+                    attr.exclude_hv = 1;
+                    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+                    const int fd = static_cast<int>(::syscall(
+                        SYS_perf_event_open, &attr, 0, -1, m_leader, PERF_FLAG_FD_CLOEXEC));
+                    if (fd < 0)
+                    {
+                        if (m_error.empty())
+                            m_error = std::string(event_name(static_cast<Event>(e))) + ": " +
+                                      std::strerror(errno);
+                        continue;
+                    }
+                    if (m_leader < 0)
+                        m_leader = fd;
+                    m_fd[e] = fd;
+                    m_slot[e] = m_members++;
+                    m_available |= 1u << e;
+                }
+                return m_available != 0;
+#else
+                m_error = "not supported on this platform";
+                return false;
+#endif
+            }
+
+            // Текущие значения, масштабированные на долю времени, когда
+            // группа была на счётчиках; пустые Counts, если группы нет
+            Counts read()
+            {
+                Counts counts;
+#if GUARD_TEST_PERF_SUPPORTED
+                if (!open())
+                    return counts;
+                // nr, time_enabled, time_running, value[nr]
+                std::uint64_t data[3 + EventCount] = {};
+                const ssize_t got = ::read(m_leader, data, sizeof(data));
+                if (got < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) ||
+                    data[0] != static_cast<std::uint64_t>(m_members))
+                    return counts;
+                const double scale =
+                    data[2] > 0 ? static_cast<double>(data[1]) / static_cast<double>(data[2]) : 0;
+                for (int e = 0; e < EventCount; ++e)
+                {
+                    if (m_fd[e] < 0)
+                        continue;
+                    counts.value[e] =
+                        static_cast<std::uint64_t>(static_cast<double>(data[3 + m_slot[e]]) * scale);
+                }
+                counts.available = data[2] > 0 ? m_available : 0;
+#endif
+                return counts;
+            }
+
+            // Почему не открылось первое из недоступных событий
+            const std::string &error() const
+            {
+                return m_error;
+            }
+
+        private:
+#if GUARD_TEST_PERF_SUPPORTED
+            static void describe(Event event, struct perf_event_attr &attr)
+            {
+                attr.type = PERF_TYPE_HARDWARE;
+                switch (event)
+                {
+                case Cycles:
+                    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                    break;
+                case Instructions:
+                    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                    break;
+                case L1dMisses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = PERF_COUNT_HW_CACHE_L1D |
+                                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                    break;
+                case LlcMisses:
+                    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                    break;
+                case BranchMisses:
+                case EventCount:
+                    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                    break;
+                }
+            }
+#endif
+
+            void close()
+            {
+#if GUARD_TEST_PERF_SUPPORTED
+                for (int e = 0; e < EventCount; ++e)
+                {
+                    if (m_fd[e] >= 0)
+                        ::close(m_fd[e]);
+                    m_fd[e] = -1;
+                }
+#endif
+                m_leader = -1;
+                m_members = 0;
+                m_available = 0;
+                m_error.clear();
+            }
+
+            int m_fd[EventCount];
+            // Позиция события в ответе read() на лидере группы
+            int m_slot[EventCount] = {};
+            int m_leader = -1;
+            int m_members = 0;
+            unsigned m_available = 0;
+            std::string m_error;
+#if GUARD_TEST_PERF_SUPPORTED
+            pid_t m_owner = 0;
+#endif
+        };
+
+        inline Group &thread_group()
+        {
+            static thread_local Group group;
+            return group;
+        }
+
+        // Текущие значения счётчиков потока (пустые, если их нет)
+        inline Counts thread_counts()
+        {
+            return thread_group().read();
+        }
+
+        // "IPC 2.31, 12.4 cycles/op, 28.6 instructions/op, ..." на ops
+        // операций; без ops (0) промахи считаются на 1000 инструкций, а
+        // без инструкций печатаются суммарные значения
+        inline std::string describe(const Counts &c, double ops)
+        {
+            if (c.empty())
+                return "unavailable";
+            double base = ops;
+            const char *unit = "/op";
+            if (ops <= 0)
+            {
+                base = c.has(Instructions) ? static_cast<double>(c.value[Instructions]) / 1000 : 0;
+                unit = "/kinstr";
+            }
+            if (base <= 0)
+            {
+                base = 1;
+                unit = "";
+            }
+            std::string text;
+            char buf[64];
+            if (c.ipc() > 0)
+            {
+                std::snprintf(buf, sizeof(buf), "IPC %.2f", c.ipc());
+                text += buf;
+            }
+            for (int e = 0; e < EventCount; ++e)
+            {
+                const Event event = static_cast<Event>(e);
+                if (!c.has(event) || (ops <= 0 && *unit && (event == Cycles || event == Instructions)))
+                    continue;
+                std::snprintf(buf,
+                              sizeof(buf),
+                              "%s%.3g %s%s",
+                              text.empty() ? "" : ", ",
+                              static_cast<double>(c.value[e]) / base,
+                              event_name(event),
+                              unit);
+                text += buf;
+            }
+            return text;
+        }
+
+        namespace detail
+        {
+            // Проверка по счётчику, которого нет, пропускается; об этом
+            // сообщается один раз на процесс, в stderr мимо перехвата std::cout
+            inline void note_unavailable(Event event)
+            {
+                static std::atomic<bool> noted(false);
+                if (noted.exchange(true))
+                    return;
+                const std::string &error = thread_group().error();
+                std::fprintf(stderr,
+                             "guard: %s are not counted (%s), checks on them are skipped\n",
+                             event_name(event),
+                             error.empty() ? "no counters" : error.c_str());
+            }
+        } // namespace detail
+    } // namespace perf
+} // namespace guard
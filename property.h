@@ -0,0 +1,819 @@
+// guard/property.h
+#pragma once
+
+#include "check.h"
+#include "env.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <initializer_list>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Тесты свойств: PROPERTY("name", генераторы...) (const T1 &a, ...) { ... }
+//
+// Генератор строит значение не из случайных чисел напрямую, а из
+// последовательности выборов Source::draw(max): в обычном режиме выборы
+// случайные и записываются, при уменьшении контрпримера — читаются из
+// изменённой записи. Уменьшение работает только с записью (удаляет
+// куски, обнуляет и уменьшает числа), поэтому любой составной генератор,
+// в том числе map/build для своих типов, уменьшается без своего кода.
+// Генераторы устроены так, что меньшие выборы дают более простые
+// значения: ближе к нулю, короче, раньше в алфавите.
+
+namespace guard
+{
+    namespace prop
+    {
+        struct Settings
+        {
+            // Базовое зерно (--seed); без него берётся из часов один раз
+            // на процесс. Зерно свойства — смесь базового и имени, так что
+            // --seed воспроизводит любое свойство отдельно от остальных
+            std::uint64_t seed = 0;
+            bool seed_set = false;
+            // Случаев на свойство (--property-cases)
+            unsigned cases = 100;
+            // Предел пробных прогонов при уменьшении контрпримера
+            unsigned max_shrinks = 10000;
+        };
+
+        inline Settings &settings()
+        {
+            static Settings instance;
+            return instance;
+        }
+
+        namespace detail
+        {
+            inline std::uint64_t splitmix64(std::uint64_t &state)
+            {
+                std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            inline std::uint64_t base_seed()
+            {
+                Settings &s = settings();
+                if (!s.seed_set)
+                {
+                    std::uint64_t clock = static_cast<std::uint64_t>(
+                        std::chrono::steady_clock::now().time_since_epoch().count());
+                    s.seed = splitmix64(clock) % 1000000000ull;
+                    s.seed_set = true;
+                }
+                return s.seed;
+            }
+
+            template <std::size_t... I>
+            struct Indices
+            {
+            };
+
+            template <std::size_t N, std::size_t... I>
+            struct MakeIndices : MakeIndices<N - 1, N - 1, I...>
+            {
+            };
+
+            template <std::size_t... I>
+            struct MakeIndices<0, I...>
+            {
+                typedef Indices<I...> type;
+            };
+
+            // Отрицательно ли значение; без сравнения беззнакового с нулём
+            template <typename T>
+            bool negative(T value, std::true_type)
+            {
+                return value < T(0);
+            }
+
+            template <typename T>
+            bool negative(T, std::false_type)
+            {
+                return false;
+            }
+
+            template <typename T>
+            bool negative(T value)
+            {
+                return negative(value, std::integral_constant<bool, std::is_signed<T>::value>());
+            }
+
+            // FNV-1a имени свойства
+            inline std::uint64_t hash_name(const char *name)
+            {
+                std::uint64_t h = 0xCBF29CE484222325ull;
+                for (const char *c = name ? name : ""; *c; ++c)
+                    h = (h ^ static_cast<unsigned char>(*c)) * 0x100000001B3ull;
+                return h;
+            }
+        } // namespace detail
+
+        // xoshiro256**
+        class Rng
+        {
+        public:
+            explicit Rng(std::uint64_t seed = 0)
+            {
+                reseed(seed);
+            }
+
+            void reseed(std::uint64_t seed)
+            {
+                for (std::uint64_t &s : m_state)
+                    s = detail::splitmix64(seed);
+            }
+
+            std::uint64_t next()
+            {
+                const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+                const std::uint64_t t = m_state[1] << 17;
+                m_state[2] ^= m_state[0];
+                m_state[3] ^= m_state[1];
+                m_state[1] ^= m_state[2];
+                m_state[0] ^= m_state[3];
+                m_state[2] ^= t;
+                m_state[3] = rotl(m_state[3], 45);
+                return result;
+            }
+
+            // В [0, bound), bound > 0; смещение остатка для тестовых
+            // данных несущественно
+            std::uint64_t below(std::uint64_t bound)
+            {
+                return next() % bound;
+            }
+
+        private:
+            static std::uint64_t rotl(std::uint64_t x, int k)
+            {
+                return (x << k) | (x >> (64 - k));
+            }
+
+            std::uint64_t m_state[4];
+        };
+
+        // Источник выборов для генераторов. Запись выборов живёт в
+        // векторах, которые переиспользуются от случая к случаю
+        class Source
+        {
+        public:
+            // Случайные выборы с записью
+            void start_random(std::uint64_t seed)
+            {
+                m_rng.reseed(seed);
+                m_replay = nullptr;
+                m_pos = 0;
+                m_record.clear();
+            }
+
+            // Выборы из записи; недостающие считаются нулями
+            void start_replay(const std::vector<std::uint64_t> &choices)
+            {
+                m_replay = &choices;
+                m_pos = 0;
+                m_record.clear();
+            }
+
+            // Число в [0, max]. Случайные выборы смещены к малым значениям:
+            // длина в битах равномерна, так что 3 выпадает не реже
+            // миллиона; иногда — ровно max, чтобы задеть границу
+            std::uint64_t draw(std::uint64_t max)
+            {
+                std::uint64_t value = 0;
+                if (m_replay)
+                {
+                    if (m_pos < m_replay->size())
+                        value = std::min((*m_replay)[m_pos++], max);
+                }
+                else if (max > 0)
+                {
+                    const std::uint64_t kind = m_rng.below(16);
+                    if (kind == 0)
+                    {
+                        value = max;
+                    }
+                    else if (kind < 4)
+                    {
+                        value = max == ~std::uint64_t(0) ? m_rng.next() : m_rng.below(max + 1);
+                    }
+                    else
+                    {
+                        const std::uint64_t bits = m_rng.below(65);
+                        value = bits == 0 ? 0 : m_rng.next() >> (64 - bits);
+                        if (value > max)
+                            value = max == ~std::uint64_t(0) ? value : value % (max + 1);
+                    }
+                }
+                m_record.push_back(value);
+                return value;
+            }
+
+            // true с вероятностью probability; при уменьшении — false
+            bool draw_bool(double probability)
+            {
+                std::uint64_t value = 0;
+                if (m_replay)
+                {
+                    if (m_pos < m_replay->size())
+                        value = (*m_replay)[m_pos++] != 0 ? 1 : 0;
+                }
+                else
+                {
+                    const double unit = static_cast<double>(m_rng.next() >> 11) / 9007199254740992.0;
+                    value = unit < probability ? 1 : 0;
+                }
+                m_record.push_back(value);
+                return value != 0;
+            }
+
+            // Продолжать ли последовательность из count элементов:
+            // флаг перед каждым необязательным элементом, так что
+            // уменьшение удаляет элемент вместе с его выборами
+            bool more(std::size_t count, std::size_t min_size, std::size_t max_size)
+            {
+                if (count < min_size)
+                    return true;
+                if (count >= max_size)
+                    return false;
+                const std::size_t range = max_size - min_size;
+                const double average = range < 8 ? static_cast<double>(range) / 2 : 8;
+                return draw_bool(average / (average + 1));
+            }
+
+            // Выборы текущего случая (фактически использованные)
+            const std::vector<std::uint64_t> &record() const
+            {
+                return m_record;
+            }
+
+            std::vector<std::uint64_t> &record()
+            {
+                return m_record;
+            }
+
+        private:
+            Rng m_rng;
+            const std::vector<std::uint64_t> *m_replay = nullptr;
+            std::size_t m_pos = 0;
+            std::vector<std::uint64_t> m_record;
+        };
+
+        // Генератор — объект с value_type и
+        //   void operator()(Source &source, value_type &out) const;
+        // Значение пишется на место out: строки и векторы сохраняют
+        // ёмкость между случаями, поэтому поток случаев не выделяет память
+        namespace gen
+        {
+            namespace detail
+            {
+                // Смещение от lo по выборам source для диапазона [0, span]
+                // с точкой origin (ноль, если он в диапазоне). Модуль
+                // отклонения от origin и знак — отдельные выборы, поэтому
+                // меньший выбор — всегда меньший модуль, и двоичный поиск
+                // при уменьшении находит наименьшее нарушающее значение;
+                // знак уменьшается к положительному
+                inline std::uint64_t offset(Source &source, std::uint64_t origin, std::uint64_t span)
+                {
+                    if (origin == 0)
+                        return source.draw(span);
+                    if (origin == span)
+                        return span - source.draw(span);
+                    const std::uint64_t left = origin;
+                    const std::uint64_t right = span - origin;
+                    const std::uint64_t magnitude = source.draw(std::max(left, right));
+                    if (source.draw_bool(0.5))
+                        return origin - std::min(magnitude, left);
+                    return origin + std::min(magnitude, right);
+                }
+            } // namespace detail
+
+            template <typename T>
+            struct Integers
+            {
+                static_assert(std::is_integral<T>::value, "integer type expected");
+                typedef T value_type;
+
+                T lo;
+                T hi;
+
+                void operator()(Source &source, T &out) const
+                {
+                    const std::uint64_t base = static_cast<std::uint64_t>(lo);
+                    const std::uint64_t span = static_cast<std::uint64_t>(hi) - base;
+                    std::uint64_t origin = 0;
+                    if (prop::detail::negative(hi))
+                        origin = span;
+                    else if (prop::detail::negative(lo))
+                        origin = std::uint64_t(0) - base;
+                    out = static_cast<T>(base + detail::offset(source, origin, span));
+                }
+            };
+
+            template <typename T>
+            Integers<T> integers(T lo = std::numeric_limits<T>::min(),
+                                 T hi = std::numeric_limits<T>::max())
+            {
+                return Integers<T>{lo, hi};
+            }
+
+            // Конечные числа в [lo, hi]: расстояние от нуля (или ближайшей
+            // к нему границы) — целая часть до 2^53, сгущённая к малым, плюс
+            // дробная; изредка — сама граница. Уменьшаются к целым и к нулю.
+            // NaN и бесконечности не порождаются
+            template <typename T>
+            struct Floats
+            {
+                static_assert(std::is_floating_point<T>::value, "floating point type expected");
+                typedef T value_type;
+
+                T lo;
+                T hi;
+
+                void operator()(Source &source, T &out) const
+                {
+                    const T origin = lo > T(0) ? lo : (hi < T(0) ? hi : T(0));
+                    const double up = static_cast<double>(hi) - static_cast<double>(origin);
+                    const double down = static_cast<double>(origin) - static_cast<double>(lo);
+                    bool below = down > 0;
+                    if (up > 0 && down > 0)
+                        below = source.draw(1) != 0;
+                    const double side = below ? down : up;
+                    const std::uint64_t cap = std::uint64_t(1) << 53;
+                    const std::uint64_t whole = source.draw(cap);
+                    const std::uint64_t fraction = source.draw(cap - 1);
+                    double distance = whole == cap ? side
+                                                   : static_cast<double>(whole) +
+                                                         static_cast<double>(fraction) / static_cast<double>(cap);
+                    if (distance > side)
+                        distance = side;
+                    const double value = below ? static_cast<double>(origin) - distance
+                                               : static_cast<double>(origin) + distance;
+                    out = static_cast<T>(value);
+                    if (out < lo)
+                        out = lo;
+                    if (out > hi)
+                        out = hi;
+                }
+            };
+
+            template <typename T>
+            Floats<T> floats(T lo = -std::numeric_limits<T>::max(),
+                             T hi = std::numeric_limits<T>::max())
+            {
+                return Floats<T>{lo, hi};
+            }
+
+            struct Booleans
+            {
+                typedef bool value_type;
+
+                void operator()(Source &source, bool &out) const
+                {
+                    out = source.draw(1) != 0;
+                }
+            };
+
+            inline Booleans booleans()
+            {
+                return Booleans();
+            }
+
+            // Строки из символов alphabet (по умолчанию печатные ASCII,
+            // сначала строчные буквы — к ним и уменьшается строка)
+            struct Strings
+            {
+                typedef std::string value_type;
+
+                std::size_t min_size;
+                std::size_t max_size;
+                const char *alphabet;
+
+                void operator()(Source &source, std::string &out) const
+                {
+                    const std::size_t letters = std::strlen(alphabet);
+                    out.clear();
+                    while (letters > 0 && source.more(out.size(), min_size, max_size))
+                        out.push_back(alphabet[source.draw(letters - 1)]);
+                }
+            };
+
+            inline Strings strings(std::size_t min_size = 0,
+                                   std::size_t max_size = 64,
+                                   const char *alphabet = nullptr)
+            {
+                static const char printable[] = "abcdefghijklmnopqrstuvwxyz"
+                                                "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                                "0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+                return Strings{min_size, max_size, alphabet ? alphabet : printable};
+            }
+
+            // std::vector: элементы строятся на месте и сохраняют свою ёмкость
+            template <typename G>
+            struct Vectors
+            {
+                typedef std::vector<typename G::value_type> value_type;
+
+                G element;
+                std::size_t min_size;
+                std::size_t max_size;
+
+                void operator()(Source &source, value_type &out) const
+                {
+                    std::size_t count = 0;
+                    while (source.more(count, min_size, max_size))
+                    {
+                        if (count == out.size())
+                            out.emplace_back();
+                        element(source, out[count]);
+                        ++count;
+                    }
+                    out.resize(count);
+                }
+            };
+
+            template <typename G>
+            Vectors<G> vectors(G element, std::size_t min_size = 0, std::size_t max_size = 64)
+            {
+                return Vectors<G>{element, min_size, max_size};
+            }
+
+            // Любой контейнер с clear() и insert(end(), value): std::set,
+            // std::list, std::deque...; элементы множеств могут совпадать,
+            // и тогда размер меньше выбранного
+            template <typename C, typename G>
+            struct Containers
+            {
+                typedef C value_type;
+
+                G element;
+                std::size_t min_size;
+                std::size_t max_size;
+
+                void operator()(Source &source, C &out) const
+                {
+                    out.clear();
+                    typename G::value_type item{};
+                    for (std::size_t count = 0; source.more(count, min_size, max_size); ++count)
+                    {
+                        element(source, item);
+                        out.insert(out.end(), item);
+                    }
+                }
+            };
+
+            template <typename C, typename G>
+            Containers<C, G> containers(G element, std::size_t min_size = 0, std::size_t max_size = 64)
+            {
+                return Containers<C, G>{element, min_size, max_size};
+            }
+
+            // Один из заданных вариантов; уменьшается к первому
+            template <typename T>
+            struct Elements
+            {
+                typedef T value_type;
+
+                std::vector<T> items;
+
+                void operator()(Source &source, T &out) const
+                {
+                    out = items[source.draw(items.size() - 1)];
+                }
+            };
+
+            template <typename T>
+            Elements<T> elements(std::initializer_list<T> items)
+            {
+                return Elements<T>{std::vector<T>(items)};
+            }
+
+            // Значение f(x) для x из генератора g
+            template <typename G, typename F>
+            struct Map
+            {
+                typedef typename std::decay<decltype(std::declval<const F &>()(
+                    std::declval<const typename G::value_type &>()))>::type value_type;
+
+                G source_gen;
+                F f;
+
+                void operator()(Source &source, value_type &out) const
+                {
+                    typename G::value_type value{};
+                    source_gen(source, value);
+                    out = f(value);
+                }
+            };
+
+            template <typename G, typename F>
+            Map<G, F> map(G g, F f)
+            {
+                return Map<G, F>{g, f};
+            }
+
+            // Свой тип: T{v1, v2, ...} из значений генераторов
+            template <typename T, typename... G>
+            struct Build
+            {
+                typedef T value_type;
+
+                std::tuple<G...> parts;
+
+                void operator()(Source &source, T &out) const
+                {
+                    std::tuple<typename G::value_type...> values;
+                    fill(source, values, std::integral_constant<std::size_t, 0>());
+                    out = make(values, typename prop::detail::MakeIndices<sizeof...(G)>::type());
+                }
+
+            private:
+
+                template <typename Values>
+                void fill(Source &, Values &, std::integral_constant<std::size_t, sizeof...(G)>) const
+                {
+                }
+
+                template <typename Values, std::size_t I>
+                void fill(Source &source, Values &values, std::integral_constant<std::size_t, I>) const
+                {
+                    std::get<I>(parts)(source, std::get<I>(values));
+                    fill(source, values, std::integral_constant<std::size_t, I + 1>());
+                }
+
+                template <typename Values, std::size_t... I>
+                static T make(Values &values, prop::detail::Indices<I...>)
+                {
+                    return T{std::move(std::get<I>(values))...};
+                }
+            };
+
+            template <typename T, typename... G>
+            Build<T, G...> build(G... parts)
+            {
+                return Build<T, G...>{std::make_tuple(parts...)};
+            }
+
+            // Произвольное построение: f(Source &) возвращает значение и
+            // сам вызывает другие генераторы или source.draw()
+            template <typename F>
+            struct Custom
+            {
+                typedef typename std::decay<decltype(std::declval<const F &>()(
+                    std::declval<Source &>()))>::type value_type;
+
+                F f;
+
+                void operator()(Source &source, value_type &out) const
+                {
+                    out = f(source);
+                }
+            };
+
+            template <typename F>
+            Custom<F> custom(F f)
+            {
+                return Custom<F>{f};
+            }
+        } // namespace gen
+
+        namespace detail
+        {
+            // Сигнатура тела свойства: void(const V1 &, const V2 &, ...)
+            template <typename Gens>
+            struct signature_of;
+
+            template <typename... G>
+            struct signature_of<std::tuple<G...>>
+            {
+                typedef void type(const typename G::value_type &...);
+            };
+
+            template <typename T>
+            void print_argument(std::ostream &os, const T &value)
+            {
+                guard::detail::print_value(os, value);
+            }
+
+            inline void print_argument(std::ostream &os, const std::string &value)
+            {
+                os << '"' << value << '"';
+            }
+
+            // Поиск контрпримера и его уменьшение для одного свойства
+            template <typename... G>
+            class Runner
+            {
+            public:
+                typedef void Body(const typename G::value_type &...);
+                typedef typename MakeIndices<sizeof...(G)>::type Seq;
+
+                Runner(const char *name, const std::tuple<G...> &gens, Body *body)
+                    : m_name(name), m_gens(gens), m_body(body)
+                {
+                }
+
+                void run()
+                {
+                    const Settings &config = settings();
+                    const std::uint64_t seed = base_seed();
+                    std::uint64_t state = seed ^ hash_name(m_name);
+                    unsigned cases = 0;
+                    bool falsified = false;
+                    for (; cases < config.cases && !falsified; ++cases)
+                    {
+                        m_source.start_random(splitmix64(state));
+                        generate(Seq());
+                        falsified = fails();
+                    }
+                    if (!falsified)
+                    {
+                        GUARD_CHECK_ENV_COUNT_ASSERT(true);
+                        return;
+                    }
+
+                    m_best = m_source.record();
+                    const unsigned steps = shrink(config.max_shrinks);
+
+                    // Минимальный контрпример: сообщение и повторный прогон
+                    // тела с обычным учётом провалов
+                    m_source.start_replay(m_best);
+                    generate(Seq());
+                    std::ostringstream msg;
+                    msg << "Property \"" << m_name << "\" falsified after " << cases
+                        << (cases == 1 ? " case" : " cases") << ", shrunk in " << steps
+                        << (steps == 1 ? " step" : " steps") << " (seed " << seed
+                        << ", rerun with --seed=" << seed << ")\n\targs: (";
+                    print(msg, Seq());
+                    msg << ")";
+                    GUARD_CHECK_ENV_COUNT_ASSERT(false);
+                    GUARD_CHECK_ENV_APPEND(msg.str());
+                    try
+                    {
+                        call(Seq());
+                    }
+                    catch (const guard_check_exception &)
+                    {
+                        throw;
+                    }
+                    catch (const std::exception &ex)
+                    {
+                        GUARD_CHECK_ENV_APPEND(std::string("\tthrows std::exception: ") + ex.what());
+                    }
+                    catch (...)
+                    {
+                        GUARD_CHECK_ENV_APPEND("\tthrows a non-std exception");
+                    }
+                }
+
+            private:
+                template <std::size_t... I>
+                void generate(Indices<I...>)
+                {
+                    int expand[] = {0, (std::get<I>(m_gens)(m_source, std::get<I>(m_values)), 0)...};
+                    (void)expand;
+                }
+
+                template <std::size_t... I>
+                void call(Indices<I...>)
+                {
+                    m_body(std::get<I>(m_values)...);
+                }
+
+                template <std::size_t... I>
+                void print(std::ostream &os, Indices<I...>)
+                {
+                    int expand[] = {
+                        0, (os << (I == 0 ? "" : ", "), print_argument(os, std::get<I>(m_values)), 0)...};
+                    (void)expand;
+                }
+
+                // Прогон тела без следов в отчёте; true — свойство нарушено
+                bool fails()
+                {
+                    const guard_check_env_mark mark = guard_check_env_save();
+                    bool failed = false;
+                    try
+                    {
+                        call(Seq());
+                        failed = guard_check_env_failed_since(mark);
+                    }
+                    catch (...)
+                    {
+                        failed = true;
+                    }
+                    guard_check_env_restore(mark);
+                    return failed;
+                }
+
+                // Пробует запись m_candidate; при провале она (в виде
+                // фактически прочитанных выборов) становится лучшей
+                bool attempt()
+                {
+                    ++m_attempts;
+                    m_source.start_replay(m_candidate);
+                    generate(Seq());
+                    if (!fails())
+                        return false;
+                    m_best.swap(m_source.record());
+                    return true;
+                }
+
+                bool exhausted() const
+                {
+                    return m_attempts >= m_max_attempts;
+                }
+
+                unsigned shrink(unsigned max_attempts)
+                {
+                    m_attempts = 0;
+                    m_max_attempts = max_attempts;
+                    unsigned steps = 0;
+                    bool changed = true;
+                    while (changed && !exhausted())
+                    {
+                        changed = false;
+                        // Удаление кусков выборов: элементы контейнеров,
+                        // символы строк
+                        for (std::size_t k = 8; k > 0 && !exhausted(); k /= 2)
+                        {
+                            std::size_t end = m_best.size();
+                            while (end >= k && !exhausted())
+                            {
+                                const std::size_t start = end - k;
+                                m_candidate.assign(m_best.begin(), m_best.begin() + start);
+                                m_candidate.insert(m_candidate.end(), m_best.begin() + end, m_best.end());
+                                if (attempt())
+                                {
+                                    ++steps;
+                                    changed = true;
+                                }
+                                end = std::min(end - 1, m_best.size());
+                            }
+                        }
+                        // Уменьшение каждого выбора: сначала ноль, затем
+                        // двоичный поиск наименьшего нарушающего значения
+                        for (std::size_t i = 0; i < m_best.size() && !exhausted(); ++i)
+                        {
+                            std::uint64_t lo = 0;
+                            std::uint64_t hi = m_best[i];
+                            while (lo < hi && i < m_best.size() && !exhausted())
+                            {
+                                const std::uint64_t mid = lo + (hi - lo) / 2;
+                                m_candidate = m_best;
+                                m_candidate[i] = mid;
+                                if (attempt())
+                                {
+                                    ++steps;
+                                    changed = true;
+                                    hi = i < m_best.size() ? std::min(mid, m_best[i]) : 0;
+                                }
+                                else
+                                {
+                                    lo = mid + 1;
+                                }
+                            }
+                        }
+                    }
+                    return steps;
+                }
+
+                const char *m_name;
+                const std::tuple<G...> &m_gens;
+                Body *m_body;
+                Source m_source;
+                std::tuple<typename G::value_type...> m_values;
+                std::vector<std::uint64_t> m_best;
+                std::vector<std::uint64_t> m_candidate;
+                unsigned m_attempts = 0;
+                unsigned m_max_attempts = 0;
+            };
+        } // namespace detail
+
+        // Проверяет свойство на settings().cases случаях. Нарушение
+        // записывается как мягкий провал с минимальным контрпримером,
+        // после чего тело прогоняется на нём ещё раз — его собственные
+        // CHECK/REQUIRE попадают в отчёт как обычно
+        template <typename... G>
+        void check(const char *name,
+                   const std::tuple<G...> &gens,
+                   typename detail::signature_of<std::tuple<G...>>::type *body)
+        {
+            detail::Runner<G...> runner(name, gens, body);
+            runner.run();
+        }
+    } // namespace prop
+} // namespace guard
@@ -0,0 +1,402 @@
+// guard/range.h
+#pragma once
+
+#include "check.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Проверки диапазонов и буферов: CHECK_RANGE_EQ, CHECK_MEM_EQ, CHECK_ALL_OF.
+//
+// Сравнение ищет только несовпадения: для непрерывных диапазонов целых,
+// перечислений и указателей (где == совпадает с побайтовым сравнением)
+// блоки сверяются memcmp, и поэлементно просматриваются только блоки с
+// отличиями. При провале в отчёт попадают окна в несколько элементов
+// вокруг первых несовпадений, а не диапазоны целиком; буферы байтов
+// печатаются как hexdump.
+
+namespace guard
+{
+    namespace range
+    {
+        // Сколько первых несовпадений показывать окнами
+        const std::size_t shown_mismatches = 4;
+        // Элементов до и после несовпадения в окне
+        const std::size_t window_context = 2;
+        // Длина строки одного элемента в окне
+        const std::size_t element_width_limit = 40;
+
+        // Несовпадения двух последовательностей; индексы первых — в first
+        struct Mismatches
+        {
+            std::size_t size_a = 0;
+            std::size_t size_b = 0;
+            std::size_t count = 0;
+            std::size_t first[shown_mismatches] = {};
+            std::size_t shown = 0;
+
+            bool ok() const
+            {
+                return size_a == size_b && count == 0;
+            }
+
+            void add(std::size_t index)
+            {
+                if (shown < shown_mismatches)
+                    first[shown++] = index;
+                ++count;
+            }
+        };
+
+        namespace detail
+        {
+            // Элементов (байтов) в блоке memcmp
+            const std::size_t block_size = 4096;
+
+            // Непрерывный диапазон: data() и size()
+            template <typename T>
+            class has_data
+            {
+                template <typename U>
+                static auto test(int) -> decltype(std::declval<const U &>().data(),
+                                                  std::declval<const U &>().size(),
+                                                  std::true_type());
+                template <typename>
+                static std::false_type test(...);
+
+            public:
+                static const bool value = decltype(test<T>(0))::value;
+            };
+
+            // Типы, для которых a == b равносильно memcmp: без NaN, -0 и
+            // байтов выравнивания
+            template <typename T>
+            struct is_bitwise
+                : std::integral_constant<bool, std::is_integral<T>::value ||
+                                                   std::is_enum<T>::value ||
+                                                   std::is_pointer<T>::value>
+            {
+            };
+
+            template <typename R>
+            std::size_t range_size(const R &r)
+            {
+                return static_cast<std::size_t>(std::distance(std::begin(r), std::end(r)));
+            }
+
+            template <typename A, typename B>
+            void compare_elements(const A &a, const B &b, Mismatches &result)
+            {
+                auto ia = std::begin(a);
+                auto ib = std::begin(b);
+                for (std::size_t i = 0; ia != std::end(a) && ib != std::end(b); ++ia, ++ib, ++i)
+                {
+                    if (!(*ia == *ib))
+                        result.add(i);
+                }
+            }
+
+            // Блоки memcmp, поэлементно — только блоки с отличиями
+            template <typename T>
+            void compare_bitwise(const T *a, const T *b, std::size_t size, Mismatches &result)
+            {
+                for (std::size_t begin = 0; begin < size; begin += block_size)
+                {
+                    const std::size_t end = std::min(size, begin + block_size);
+                    if (std::memcmp(a + begin, b + begin, (end - begin) * sizeof(T)) == 0)
+                        continue;
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        if (!(a[i] == b[i]))
+                            result.add(i);
+                    }
+                }
+            }
+
+            template <typename A, typename B>
+            void compare(const A &a, const B &b, Mismatches &result, std::false_type)
+            {
+                compare_elements(a, b, result);
+            }
+
+            template <typename A, typename B>
+            void compare(const A &a, const B &b, Mismatches &result, std::true_type)
+            {
+                compare_bitwise(a.data(), b.data(), std::min(result.size_a, result.size_b), result);
+            }
+
+            template <typename T, std::size_t N, typename B>
+            void compare(const T (&a)[N], const B &b, Mismatches &result, std::true_type)
+            {
+                compare_bitwise(&a[0], b.data(), std::min(result.size_a, result.size_b), result);
+            }
+
+            template <typename A, typename T, std::size_t N>
+            void compare(const A &a, const T (&b)[N], Mismatches &result, std::true_type)
+            {
+                compare_bitwise(a.data(), &b[0], std::min(result.size_a, result.size_b), result);
+            }
+
+            template <typename T, std::size_t N, typename U, std::size_t M>
+            void compare(const T (&a)[N], const U (&b)[M], Mismatches &result, std::true_type)
+            {
+                compare_bitwise(&a[0], &b[0], std::min(result.size_a, result.size_b), result);
+            }
+
+            template <typename R>
+            struct element_of
+            {
+                typedef typename std::decay<decltype(*std::begin(std::declval<const R &>()))>::type
+                    type;
+            };
+
+            template <typename R>
+            struct is_contiguous
+                : std::integral_constant<bool, has_data<R>::value || std::is_array<R>::value>
+            {
+            };
+
+            // memcmp годится, если оба диапазона непрерывны и из одного
+            // побитово сравнимого типа
+            template <typename A, typename B>
+            struct use_memcmp
+                : std::integral_constant<
+                      bool,
+                      is_contiguous<A>::value && is_contiguous<B>::value &&
+                          std::is_same<typename element_of<A>::type,
+                                       typename element_of<B>::type>::value &&
+                          is_bitwise<typename element_of<A>::type>::value>
+            {
+            };
+
+            template <typename T>
+            std::string element_text(const T &value)
+            {
+                std::ostringstream os;
+                guard::detail::print_value(os, value);
+                std::string text = os.str();
+                if (text.size() > element_width_limit)
+                    text = text.substr(0, element_width_limit - 3) + "...";
+                return text;
+            }
+
+            // Тексты элементов [lo, hi) диапазона; за концом — пусто
+            template <typename R>
+            std::vector<std::string> window_texts(const R &r, std::size_t size,
+                                                  std::size_t lo, std::size_t hi)
+            {
+                std::vector<std::string> texts(hi - lo);
+                auto it = std::begin(r);
+                std::advance(it, std::min(lo, size));
+                for (std::size_t i = lo; i < hi && i < size; ++i, ++it)
+                    texts[i - lo] = element_text(*it);
+                return texts;
+            }
+
+            // Окна [lo, hi) вокруг первых несовпадений; соседние сливаются
+            inline std::vector<std::pair<std::size_t, std::size_t>>
+            windows(const Mismatches &m, std::size_t context, std::size_t limit)
+            {
+                std::vector<std::pair<std::size_t, std::size_t>> result;
+                for (std::size_t k = 0; k < m.shown; ++k)
+                {
+                    const std::size_t i = m.first[k];
+                    const std::size_t lo = i > context ? i - context : 0;
+                    const std::size_t hi = std::min(limit, i + context + 1);
+                    if (!result.empty() && lo <= result.back().second)
+                        result.back().second = std::max(result.back().second, hi);
+                    else
+                        result.push_back(std::make_pair(lo, hi));
+                }
+                return result;
+            }
+
+            inline void pad(std::string &line, std::size_t width)
+            {
+                if (line.size() < width)
+                    line.append(width - line.size(), ' ');
+            }
+
+            inline std::string trim_right(const std::string &line)
+            {
+                return line.substr(0, line.find_last_not_of(' ') + 1);
+            }
+        } // namespace detail
+
+        // Поэлементное сравнение двух диапазонов
+        template <typename A, typename B>
+        Mismatches compare(const A &a, const B &b)
+        {
+            Mismatches result;
+            result.size_a = detail::range_size(a);
+            result.size_b = detail::range_size(b);
+            detail::compare(a, b, result, detail::use_memcmp<A, B>());
+            // Хвост длинного диапазона — тоже несовпадения, но в окна
+            // попадает только его начало
+            if (result.size_a != result.size_b)
+                result.add(std::min(result.size_a, result.size_b));
+            return result;
+        }
+
+        // "2 of 1000 elements differ" и окна вида
+        //   [14..19] a: 14 15 16 17 18 19
+        //            b: 14 15 99 17 18 19
+        //                     ^^
+        template <typename A, typename B>
+        std::string describe(const Mismatches &m, const A &a, const B &b)
+        {
+            std::ostringstream os;
+            if (m.size_a != m.size_b)
+            {
+                os << "sizes differ: " << m.size_a << " vs " << m.size_b;
+                if (m.count > 1)
+                    os << ", " << m.count - 1 << " of the first "
+                       << std::min(m.size_a, m.size_b) << " elements differ";
+            }
+            else
+                os << m.count << " of " << m.size_a
+                   << (m.size_a == 1 ? " element differs" : " elements differ");
+            const std::size_t limit = std::max(m.size_a, m.size_b);
+            for (const auto &w : detail::windows(m, window_context, limit))
+            {
+                const std::vector<std::string> ta = detail::window_texts(a, m.size_a, w.first, w.second);
+                const std::vector<std::string> tb = detail::window_texts(b, m.size_b, w.first, w.second);
+                std::ostringstream head;
+                head << "\n\t[" << w.first << ".." << w.second - 1 << "] ";
+                const std::string indent(head.str().size() - 2, ' ');
+                std::string line_a = "a: ";
+                std::string line_b = "b: ";
+                std::string marks = "   ";
+                for (std::size_t k = 0; k < ta.size(); ++k)
+                {
+                    const std::size_t width = std::max(ta[k].size(), tb[k].size());
+                    const std::size_t i = w.first + k;
+                    const bool differs = i >= m.size_a || i >= m.size_b || ta[k] != tb[k] ||
+                                         std::find(m.first, m.first + m.shown, i) != m.first + m.shown;
+                    line_a += ta[k];
+                    detail::pad(line_a, line_a.size() + width - ta[k].size() + 1);
+                    line_b += tb[k];
+                    detail::pad(line_b, line_b.size() + width - tb[k].size() + 1);
+                    marks.append(width, differs ? '^' : ' ');
+                    marks += ' ';
+                }
+                os << head.str() << detail::trim_right(line_a) << "\n\t" << indent
+                   << detail::trim_right(line_b) << "\n\t" << indent << detail::trim_right(marks);
+            }
+            if (m.count > m.shown)
+                os << "\n\t...";
+            return os.str();
+        }
+
+        // ----- буферы байтов -----
+
+        inline Mismatches compare_bytes(const void *a, const void *b, std::size_t size)
+        {
+            Mismatches result;
+            result.size_a = size;
+            result.size_b = size;
+            detail::compare_bitwise(static_cast<const unsigned char *>(a),
+                                    static_cast<const unsigned char *>(b),
+                                    size,
+                                    result);
+            return result;
+        }
+
+        // Строки hexdump по 16 байт с первыми несовпадениями:
+        //   0x00000010 a: 00 41 42 43 ...  |.ABC...|
+        //              b: 00 41 58 43 ...  |.AXC...|
+        //                       ^^
+        inline std::string describe_bytes(const Mismatches &m, const void *a, const void *b)
+        {
+            const unsigned char *pa = static_cast<const unsigned char *>(a);
+            const unsigned char *pb = static_cast<const unsigned char *>(b);
+            std::ostringstream os;
+            os << m.count << " of " << m.size_a << (m.size_a == 1 ? " byte differs" : " bytes differ")
+               << ", first at offset " << (m.shown ? m.first[0] : 0);
+            std::size_t last_row = ~std::size_t(0);
+            for (std::size_t k = 0; k < m.shown; ++k)
+            {
+                const std::size_t row = m.first[k] / 16 * 16;
+                if (row == last_row)
+                    continue;
+                last_row = row;
+                char offset[32];
+                std::snprintf(offset, sizeof(offset), "0x%08llx ", static_cast<unsigned long long>(row));
+                const std::string indent(std::strlen(offset), ' ');
+                std::string hex_a, hex_b, marks, text_a, text_b;
+                for (std::size_t i = row; i < row + 16; ++i)
+                {
+                    if (i >= m.size_a)
+                    {
+                        hex_a += "   ";
+                        hex_b += "   ";
+                        marks += "   ";
+                        continue;
+                    }
+                    char byte[4];
+                    std::snprintf(byte, sizeof(byte), "%02x ", pa[i]);
+                    hex_a += byte;
+                    std::snprintf(byte, sizeof(byte), "%02x ", pb[i]);
+                    hex_b += byte;
+                    marks += pa[i] != pb[i] ? "^^ " : "   ";
+                    text_a += (pa[i] >= 0x20 && pa[i] < 0x7f) ? static_cast<char>(pa[i]) : '.';
+                    text_b += (pb[i] >= 0x20 && pb[i] < 0x7f) ? static_cast<char>(pb[i]) : '.';
+                }
+                os << "\n\t" << offset << "a: " << hex_a << " |" << text_a << "|"
+                   << "\n\t" << indent << "b: " << hex_b << " |" << text_b << "|"
+                   << "\n\t" << indent << "   " << detail::trim_right(marks);
+            }
+            if (m.count > m.shown)
+                os << "\n\t...";
+            return os.str();
+        }
+
+        // ----- предикат над диапазоном -----
+
+        // Элементы, не удовлетворяющие pred; первые печатаются со значениями
+        struct Violations
+        {
+            std::size_t size = 0;
+            std::size_t count = 0;
+            std::string first;
+        };
+
+        template <typename R, typename Pred>
+        Violations all_of(const R &r, Pred pred)
+        {
+            Violations result;
+            std::size_t i = 0;
+            for (auto it = std::begin(r); it != std::end(r); ++it, ++i)
+            {
+                if (pred(*it))
+                    continue;
+                if (result.count < shown_mismatches * 2)
+                {
+                    result.first += result.count == 0 ? "[" : ", [";
+                    result.first += std::to_string(i) + "] " + detail::element_text(*it);
+                }
+                ++result.count;
+            }
+            result.size = i;
+            return result;
+        }
+
+        inline std::string describe(const Violations &v)
+        {
+            std::ostringstream os;
+            os << v.count << " of " << v.size << (v.size == 1 ? " element fails" : " elements fail")
+               << ": " << v.first;
+            if (v.count > shown_mismatches * 2)
+                os << ", ...";
+            return os.str();
+        }
+    } // namespace range
+} // namespace guard
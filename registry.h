@@ -0,0 +1,207 @@
+// guard/registry.h
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+
+namespace guard
+{
+    namespace detail
+    {
+        // Сравнение C-строк без временных std::string; nullptr — пустая строка.
+        // Имена файлов из __FILE__ одной единицы трансляции обычно совпадают
+        // по адресу, тогда strcmp не нужен
+        inline int compare_cstr(const char *lhs, const char *rhs)
+        {
+            if (lhs == rhs)
+                return 0;
+            return std::strcmp(lhs ? lhs : "", rhs ? rhs : "");
+        }
+
+        struct CStrLess
+        {
+            bool operator()(const char *lhs, const char *rhs) const
+            {
+                return compare_cstr(lhs, rhs) < 0;
+            }
+        };
+
+        // Порядок регистрации: файл, строка, имя
+        template <typename Node>
+        bool location_less(const Node &lhs, const Node &rhs)
+        {
+            const int by_file = compare_cstr(lhs.file, rhs.file);
+            if (by_file != 0)
+                return by_file < 0;
+            if (lhs.line != rhs.line)
+                return lhs.line < rhs.line;
+            return compare_cstr(lhs.name, rhs.name) < 0;
+        }
+
+        // Односвязный список узлов в статической памяти: узел — поле
+        // регистратора, поэтому регистрация не выделяет память. У списка
+        // нет конструкторов, он обнуляется статически до любых динамических
+        // инициализаторов, и порядок инициализации единиц трансляции не важен.
+        // Node должен иметь поле Node *next.
+        template <typename Node>
+        struct IntrusiveList
+        {
+            Node *head;
+            Node *tail;
+            std::size_t count;
+            bool sorted;
+
+            class iterator
+            {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef Node value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef Node *pointer;
+                typedef Node &reference;
+
+                explicit iterator(Node *node) : m_node(node)
+                {
+                }
+
+                Node &operator*() const
+                {
+                    return *m_node;
+                }
+
+                Node *operator->() const
+                {
+                    return m_node;
+                }
+
+                iterator &operator++()
+                {
+                    m_node = m_node->next;
+                    return *this;
+                }
+
+                bool operator==(const iterator &other) const
+                {
+                    return m_node == other.m_node;
+                }
+
+                bool operator!=(const iterator &other) const
+                {
+                    return m_node != other.m_node;
+                }
+
+            private:
+                Node *m_node;
+            };
+
+            void push_back(Node *node)
+            {
+                node->next = nullptr;
+                if (tail)
+                    tail->next = node;
+                else
+                    head = node;
+                tail = node;
+                ++count;
+                sorted = false;
+            }
+
+            std::size_t size() const
+            {
+                return count;
+            }
+
+            bool empty() const
+            {
+                return count == 0;
+            }
+
+            iterator begin() const
+            {
+                return iterator(head);
+            }
+
+            iterator end() const
+            {
+                return iterator(nullptr);
+            }
+
+            // Устойчивая естественная сортировка слиянием на месте, без
+            // выделений памяти. Каждый проход сливает соседние упорядоченные
+            // серии; узлы одной единицы трансляции регистрируются по
+            // возрастанию строк и уже образуют серию, поэтому проходов около
+            // log2(числа файлов). Повторный вызов без новых узлов бесплатен
+            template <typename Less>
+            void sort(Less less)
+            {
+                if (sorted)
+                    return;
+                for (;;)
+                {
+                    Node *rest = head;
+                    Node *merged = nullptr;
+                    Node *merged_tail = nullptr;
+                    std::size_t runs = 0;
+                    while (rest)
+                    {
+                        Node *a = rest;
+                        rest = cut_run(a, less);
+                        Node *b = rest;
+                        if (b)
+                            rest = cut_run(b, less);
+                        Node *part_tail = nullptr;
+                        Node *part = merge(a, b, less, part_tail);
+                        if (merged_tail)
+                            merged_tail->next = part;
+                        else
+                            merged = part;
+                        merged_tail = part_tail;
+                        ++runs;
+                    }
+                    head = merged;
+                    tail = merged_tail;
+                    if (runs <= 1)
+                        break;
+                }
+                sorted = true;
+            }
+
+        private:
+            // Отрезает упорядоченную серию, начинающуюся с start;
+            // возвращает узел после неё
+            template <typename Less>
+            static Node *cut_run(Node *start, Less &less)
+            {
+                Node *node = start;
+                while (node->next && !less(*node->next, *node))
+                    node = node->next;
+                Node *after = node->next;
+                node->next = nullptr;
+                return after;
+            }
+
+            template <typename Less>
+            static Node *merge(Node *a, Node *b, Less &less, Node *&last)
+            {
+                Node *result = nullptr;
+                Node **out = &result;
+                Node *prev = nullptr;
+                while (a && b)
+                {
+                    Node *&from = less(*b, *a) ? b : a;
+                    *out = from;
+                    prev = from;
+                    out = &from->next;
+                    from = from->next;
+                }
+                *out = a ? a : b;
+                Node *node = *out ? *out : prev;
+                while (node && node->next)
+                    node = node->next;
+                last = node;
+                return result;
+            }
+        };
+    } // namespace detail
+} // namespace guard
@@ -0,0 +1,444 @@
+// guard/reporter.h
+#pragma once
+
+#include "bench.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace guard
+{
+    namespace report
+    {
+        // Итог одного теста в том виде, в каком его видят отчёты
+        struct Record
+        {
+            const char *name;
+            const char *file;
+            int line;
+            const char *tags;
+            bool passed;
+            // Настенное и процессорное время, мкс (0 — рабочий процесс упал)
+            double wall_us;
+            double cpu_us;
+            unsigned long long asserts_total;
+            unsigned long long asserts_failed;
+            unsigned long long alloc_count;
+            unsigned long long alloc_bytes;
+            // Текст провалов и перехваченный вывод (пустые у прошедших)
+            const std::string *error;
+            const std::string *output;
+            // Аппаратные счётчики (пустые, если не снимались)
+            const perf::Counts *perf;
+        };
+
+        struct Totals
+        {
+            unsigned long long tests = 0;
+            unsigned long long failed = 0;
+            double wall_us = 0;
+        };
+
+        // Потоковый отчёт: запись о тесте пишется сразу после его
+        // завершения и сбрасывается на диск, поэтому CI видит прогресс, а
+        // память не зависит от числа тестов. Раннер вызывает методы под
+        // своей блокировкой, из любых потоков по очереди.
+        class Reporter
+        {
+        public:
+            virtual ~Reporter() = default;
+
+            // tests — сколько тестов будет запущено
+            virtual void begin(std::size_t tests)
+            {
+                (void)tests;
+            }
+
+            virtual void test(const Record &record) = 0;
+
+            virtual void end(const Totals &totals)
+            {
+                (void)totals;
+            }
+
+            // false — файл отчёта не удалось открыть или записать
+            virtual bool good() const = 0;
+        };
+
+        namespace detail
+        {
+            // Текст для XML: служебные символы экранируются, управляющие
+            // (кроме \t, \n, \r) в XML 1.0 недопустимы и заменяются пробелом,
+            // байты вне корректного UTF-8 и U+FFFE/U+FFFF — на U+FFFD
+            inline void write_xml_text(std::ostream &os, const char *s, std::size_t size)
+            {
+                for (std::size_t i = 0; i < size;)
+                {
+                    const unsigned char ch = static_cast<unsigned char>(s[i]);
+                    if (ch >= 0x80)
+                    {
+                        const std::size_t n = bench::detail::utf8_length(s + i, size - i);
+                        const bool nonchar = n == 3 && ch == 0xef &&
+                                             static_cast<unsigned char>(s[i + 1]) == 0xbf &&
+                                             static_cast<unsigned char>(s[i + 2]) >= 0xbe;
+                        if (n == 0 || nonchar)
+                            os << bench::detail::utf8_replacement;
+                        else
+                            os.write(s + i, static_cast<std::streamsize>(n));
+                        i += n == 0 ? 1 : n;
+                        continue;
+                    }
+                    switch (ch)
+                    {
+                    case '&':
+                        os << "&amp;";
+                        break;
+                    case '<':
+                        os << "&lt;";
+                        break;
+                    case '>':
+                        os << "&gt;";
+                        break;
+                    case '"':
+                        os << "&quot;";
+                        break;
+                    case '\t':
+                    case '\n':
+                    case '\r':
+                        os << s[i];
+                        break;
+                    default:
+                        os << (ch < 0x20 ? ' ' : s[i]);
+                        break;
+                    }
+                    ++i;
+                }
+            }
+
+            inline void write_xml_text(std::ostream &os, const char *s)
+            {
+                write_xml_text(os, s ? s : "", s ? std::strlen(s) : 0);
+            }
+
+            inline void write_xml_text(std::ostream &os, const std::string &s)
+            {
+                write_xml_text(os, s.data(), s.size());
+            }
+
+            // Многострочный текст как YAML-блок "|" с отступом indent;
+            // управляющие символы, кроме табуляции, отбрасываются
+            inline void write_yaml_block(std::ostream &os, const std::string &text, const char *indent)
+            {
+                os << indent;
+                for (std::size_t i = 0; i < text.size(); ++i)
+                {
+                    const unsigned char ch = static_cast<unsigned char>(text[i]);
+                    if (ch == '\n')
+                    {
+                        if (i + 1 < text.size())
+                            os << '\n' << indent;
+                    }
+                    else if (ch >= 0x20 || ch == '\t')
+                    {
+                        os << text[i];
+                    }
+                }
+                os << '\n';
+            }
+
+            inline std::unique_ptr<std::ofstream> open_report(const char *path)
+            {
+                std::unique_ptr<std::ofstream> out(new std::ofstream(path, std::ios::trunc));
+                if (!*out)
+                    return nullptr;
+                return out;
+            }
+        } // namespace detail
+
+        // Одна JSON-строка на тест:
+        // {"name": ..., "file": ..., "line": ..., "tags": ..., "status":
+        //  "passed"|"failed", "wall_us": ..., "cpu_us": ..., "asserts": ...,
+        //  "asserts_failed": ..., "allocs": ..., "alloc_bytes": ...,
+        //  "error": ..., "output": ..., "perf": {"cycles": ..., ...}}
+        // Последняя строка — {"summary": {"tests": ..., "failed": ...,
+        // "wall_us": ...}}
+        class JsonLinesReporter : public Reporter
+        {
+        public:
+            explicit JsonLinesReporter(const char *path) : m_out(detail::open_report(path))
+            {
+                if (m_out)
+                    *m_out << std::fixed << std::setprecision(3);
+            }
+
+            void test(const Record &r) override
+            {
+                if (!m_out)
+                    return;
+                std::ostream &out = *m_out;
+                out << "{\"name\": ";
+                bench::detail::write_json_string(out, r.name);
+                out << ", \"file\": ";
+                bench::detail::write_json_string(out, r.file ? r.file : "");
+                out << ", \"line\": " << r.line;
+                if (r.tags)
+                {
+                    out << ", \"tags\": ";
+                    bench::detail::write_json_string(out, r.tags);
+                }
+                out << ", \"status\": \"" << (r.passed ? "passed" : "failed")
+                    << "\", \"wall_us\": " << r.wall_us << ", \"cpu_us\": " << r.cpu_us
+                    << ", \"asserts\": " << r.asserts_total
+                    << ", \"asserts_failed\": " << r.asserts_failed
+                    << ", \"allocs\": " << r.alloc_count
+                    << ", \"alloc_bytes\": " << r.alloc_bytes;
+                if (r.error && !r.error->empty())
+                {
+                    out << ", \"error\": ";
+                    bench::detail::write_json_string(out, *r.error);
+                }
+                if (r.output && !r.output->empty())
+                {
+                    out << ", \"output\": ";
+                    bench::detail::write_json_string(out, *r.output);
+                }
+                if (r.perf && !r.perf->empty())
+                {
+                    const char *const keys[] = {
+                        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+                    out << ", \"perf\": {";
+                    const char *separator = "";
+                    for (int e = 0; e < perf::EventCount; ++e)
+                    {
+                        if (!r.perf->has(static_cast<perf::Event>(e)))
+                            continue;
+                        out << separator << "\"" << keys[e] << "\": " << r.perf->value[e];
+                        separator = ", ";
+                    }
+                    out << "}";
+                }
+                out << "}\n";
+                out.flush();
+            }
+
+            void end(const Totals &totals) override
+            {
+                if (!m_out)
+                    return;
+                *m_out << "{\"summary\": {\"tests\": " << totals.tests
+                       << ", \"failed\": " << totals.failed
+                       << ", \"wall_us\": " << totals.wall_us << "}}\n";
+                m_out->flush();
+            }
+
+            bool good() const override
+            {
+                return m_out && m_out->good();
+            }
+
+        private:
+            std::unique_ptr<std::ofstream> m_out;
+        };
+
+        // JUnit XML. Элементы testcase пишутся по мере завершения тестов;
+        // число тестов, провалов и общее время в заголовке testsuite
+        // известны только в конце, поэтому там стоят поля фиксированной
+        // ширины, которые end() переписывает на месте (если файл
+        // позволяет перемотку; в канал уходят нули)
+        class JUnitReporter : public Reporter
+        {
+        public:
+            explicit JUnitReporter(const char *path) : m_out(detail::open_report(path))
+            {
+            }
+
+            void begin(std::size_t tests) override
+            {
+                (void)tests;
+                if (!m_out)
+                    return;
+                *m_out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n";
+                m_header_pos = m_out->tellp();
+                write_header(Totals());
+                m_out->flush();
+            }
+
+            void test(const Record &r) override
+            {
+                if (!m_out)
+                    return;
+                std::ostream &out = *m_out;
+                char time[32];
+                std::snprintf(time, sizeof(time), "%.6f", r.wall_us / 1e6);
+                out << "  <testcase classname=\"";
+                detail::write_xml_text(out, r.file);
+                out << "\" name=\"";
+                detail::write_xml_text(out, r.name);
+                out << "\" file=\"";
+                detail::write_xml_text(out, r.file);
+                out << "\" line=\"" << r.line << "\" time=\"" << time
+                    << "\" assertions=\"" << r.asserts_total << "\"";
+                const bool has_error = r.error && !r.error->empty();
+                const bool has_output = r.output && !r.output->empty();
+                if (r.passed && !has_output)
+                {
+                    out << "/>\n";
+                    out.flush();
+                    return;
+                }
+                out << ">\n";
+                if (!r.passed)
+                {
+                    out << "    <failure message=\"" << r.asserts_failed
+                        << " failed assertions\">";
+                    if (has_error)
+                        detail::write_xml_text(out, *r.error);
+                    out << "</failure>\n";
+                }
+                if (has_output)
+                {
+                    out << "    <system-out>";
+                    detail::write_xml_text(out, *r.output);
+                    out << "</system-out>\n";
+                }
+                out << "  </testcase>\n";
+                out.flush();
+            }
+
+            void end(const Totals &totals) override
+            {
+                if (!m_out)
+                    return;
+                *m_out << "  </testsuite>\n</testsuites>\n";
+                m_out->flush();
+                if (m_header_pos != std::streampos(-1) && m_out->seekp(m_header_pos))
+                {
+                    write_header(totals);
+                    m_out->seekp(0, std::ios::end);
+                    m_out->flush();
+                }
+                else
+                {
+                    m_out->clear();
+                }
+            }
+
+            bool good() const override
+            {
+                return m_out && m_out->good();
+            }
+
+        private:
+            void write_header(const Totals &totals)
+            {
+                char header[160];
+                std::snprintf(header,
+                              sizeof(header),
+                              "  <testsuite name=\"guard\" tests=\"%010llu\" failures=\"%010llu\" "
+                              "errors=\"0\" time=\"%017.6f\">\n",
+                              totals.tests,
+                              totals.failed,
+                              totals.wall_us / 1e6);
+                *m_out << header;
+            }
+
+            std::unique_ptr<std::ofstream> m_out;
+            std::streampos m_header_pos = std::streampos(-1);
+        };
+
+        // TAP версии 13: план "1..N" в начале, затем "ok"/"not ok" на каждый
+        // тест в порядке завершения; подробности провала — YAML-блоком
+        class TapReporter : public Reporter
+        {
+        public:
+            explicit TapReporter(const char *path) : m_out(detail::open_report(path))
+            {
+                if (m_out)
+                    *m_out << std::fixed << std::setprecision(3);
+            }
+
+            void begin(std::size_t tests) override
+            {
+                if (!m_out)
+                    return;
+                *m_out << "TAP version 13\n1.." << tests << "\n";
+                m_out->flush();
+            }
+
+            void test(const Record &r) override
+            {
+                if (!m_out)
+                    return;
+                std::ostream &out = *m_out;
+                out << (r.passed ? "ok " : "not ok ") << ++m_number << " - ";
+                // '#' в описании начинает директиву TAP
+                for (const char *c = r.name; *c; ++c)
+                {
+                    if (*c == '#')
+                        out << '\\';
+                    if (*c != '\n')
+                        out << *c;
+                }
+                out << "\n";
+                if (!r.passed)
+                {
+                    // Строка JSON — допустимая строка YAML в кавычках
+                    out << "  ---\n  file: ";
+                    bench::detail::write_json_string(out, r.file ? r.file : "");
+                    out << "\n  line: " << r.line
+                        << "\n  duration_ms: " << r.wall_us / 1e3
+                        << "\n  asserts: " << r.asserts_total
+                        << "\n  asserts_failed: " << r.asserts_failed << "\n";
+                    if (r.error && !r.error->empty())
+                    {
+                        out << "  message: |\n";
+                        detail::write_yaml_block(out, *r.error, "    ");
+                    }
+                    if (r.output && !r.output->empty())
+                    {
+                        out << "  output: |\n";
+                        detail::write_yaml_block(out, *r.output, "    ");
+                    }
+                    out << "  ...\n";
+                }
+                out.flush();
+            }
+
+            bool good() const override
+            {
+                return m_out && m_out->good();
+            }
+
+        private:
+            std::unique_ptr<std::ofstream> m_out;
+            unsigned long long m_number = 0;
+        };
+
+        // Отчёт по описанию "формат:путь" (junit, jsonl, tap); nullptr,
+        // если формат неизвестен или файл не открылся
+        inline std::unique_ptr<Reporter> make_reporter(const char *spec)
+        {
+            const char *colon = std::strchr(spec, ':');
+            if (!colon || colon[1] == '\0')
+                return nullptr;
+            const std::string format(spec, colon);
+            const char *path = colon + 1;
+            std::unique_ptr<Reporter> reporter;
+            if (format == "junit")
+                reporter.reset(new JUnitReporter(path));
+            else if (format == "jsonl")
+                reporter.reset(new JsonLinesReporter(path));
+            else if (format == "tap")
+                reporter.reset(new TapReporter(path));
+            if (reporter && !reporter->good())
+                reporter.reset();
+            return reporter;
+        }
+    } // namespace report
+} // namespace guard
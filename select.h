@@ -0,0 +1,250 @@
+// guard/select.h
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace guard
+{
+    namespace detail
+    {
+        // Сопоставление с шаблоном: '*' — любая подстрока, '?' — любой символ.
+        // Жадный проход с откатом к последней '*': без рекурсии и выделений
+        inline bool glob_match(const char *pattern, const char *pattern_end,
+                               const char *text, const char *text_end)
+        {
+            const char *star = nullptr;
+            const char *resume = nullptr;
+            while (text != text_end)
+            {
+                // '*' проверяется первой: иначе она совпала бы с буквальной
+                // '*' в имени и перестала бы быть подстановкой
+                if (pattern != pattern_end && *pattern == '*')
+                {
+                    star = pattern++;
+                    resume = text;
+                }
+                else if (pattern != pattern_end && (*pattern == '?' || *pattern == *text))
+                {
+                    ++pattern;
+                    ++text;
+                }
+                else if (star)
+                {
+                    pattern = star + 1;
+                    text = ++resume;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            while (pattern != pattern_end && *pattern == '*')
+                ++pattern;
+            return pattern == pattern_end;
+        }
+
+        // Следующая метка вида "[tag]" в строке меток; пробелы между
+        // метками пропускаются. Возвращает false, когда меток больше нет
+        inline bool next_tag(const char *&cursor, const char *end,
+                             const char *&tag, const char *&tag_end)
+        {
+            while (cursor != end && *cursor != '[')
+                ++cursor;
+            if (cursor == end)
+                return false;
+            tag = ++cursor;
+            while (cursor != end && *cursor != ']')
+                ++cursor;
+            tag_end = cursor;
+            if (cursor != end)
+                ++cursor;
+            return true;
+        }
+
+        // Выражение отбора тестов, разобранное один раз до прогона.
+        //
+        // Шаблоны разделяются запятыми (запятая в шаблоне экранируется как
+        // "\,"). Шаблон без '*' и '?' ищется как подстрока, с ними — должен
+        // совпасть целиком, "=name" — точное совпадение. Шаблон имени из
+        // меток "[fast][db*]" требует, чтобы у теста нашлась каждая метка.
+        // Тест выбран, если подходит хотя бы под одно включение каждого
+        // вида (имя, файл) и ни под одно исключение.
+        class Selector
+        {
+        public:
+            void include_names(const char *expression)
+            {
+                add(expression, m_names);
+            }
+
+            void exclude_names(const char *expression)
+            {
+                add(expression, m_names_excluded);
+            }
+
+            void include_files(const char *expression)
+            {
+                add(expression, m_files);
+            }
+
+            void exclude_files(const char *expression)
+            {
+                add(expression, m_files_excluded);
+            }
+
+            bool empty() const
+            {
+                return m_names.empty() && m_names_excluded.empty() &&
+                       m_files.empty() && m_files_excluded.empty();
+            }
+
+            // Проверка одного теста; tags может быть nullptr
+            bool matches(const char *name, const char *file, const char *tags) const
+            {
+                if (empty())
+                    return true;
+                name = name ? name : "";
+                file = file ? file : "";
+                tags = tags ? tags : "";
+                if (!m_names.empty() && !any(m_names, name, tags))
+                    return false;
+                if (!m_files.empty() && !any(m_files, file, ""))
+                    return false;
+                if (any(m_names_excluded, name, tags))
+                    return false;
+                return !any(m_files_excluded, file, "");
+            }
+
+        private:
+            enum Kind
+            {
+                Substring,
+                Glob,
+                Exact,
+                Tags
+            };
+
+            // Текст шаблона лежит в m_text с завершающим нулём; храним
+            // смещения, потому что m_text растёт при добавлении шаблонов
+            struct Pattern
+            {
+                Kind kind;
+                std::size_t begin;
+                std::size_t size;
+            };
+
+            void add(const char *expression, std::vector<Pattern> &out)
+            {
+                if (!expression)
+                    return;
+                std::string item;
+                for (const char *c = expression;; ++c)
+                {
+                    if (*c == '\\' && c[1] == ',')
+                    {
+                        item.push_back(*++c);
+                        continue;
+                    }
+                    if (*c != ',' && *c != '\0')
+                    {
+                        item.push_back(*c);
+                        continue;
+                    }
+                    if (!item.empty())
+                        out.push_back(compile(item));
+                    item.clear();
+                    if (*c == '\0')
+                        break;
+                }
+            }
+
+            Pattern compile(const std::string &item)
+            {
+                Pattern pattern;
+                std::size_t skip = 0;
+                if (item[0] == '=')
+                {
+                    pattern.kind = Exact;
+                    skip = 1;
+                }
+                else if (item[0] == '[')
+                {
+                    pattern.kind = Tags;
+                }
+                else if (item.find_first_of("*?") != std::string::npos)
+                {
+                    pattern.kind = Glob;
+                }
+                else
+                {
+                    pattern.kind = Substring;
+                }
+                pattern.begin = m_text.size();
+                pattern.size = item.size() - skip;
+                m_text.append(item, skip, std::string::npos);
+                m_text.push_back('\0');
+                return pattern;
+            }
+
+            bool any(const std::vector<Pattern> &patterns, const char *text, const char *tags) const
+            {
+                std::size_t text_size = std::string::npos;
+                for (const Pattern &p : patterns)
+                {
+                    const char *pattern = m_text.data() + p.begin;
+                    switch (p.kind)
+                    {
+                    case Substring:
+                        if (std::strstr(text, pattern))
+                            return true;
+                        break;
+                    case Exact:
+                        if (std::strcmp(text, pattern) == 0)
+                            return true;
+                        break;
+                    case Glob:
+                        if (text_size == std::string::npos)
+                            text_size = std::strlen(text);
+                        if (glob_match(pattern, pattern + p.size, text, text + text_size))
+                            return true;
+                        break;
+                    case Tags:
+                        if (has_tags(pattern, pattern + p.size, tags))
+                            return true;
+                        break;
+                    }
+                }
+                return false;
+            }
+
+            // Каждая метка шаблона должна совпасть хотя бы с одной меткой теста
+            static bool has_tags(const char *pattern, const char *pattern_end, const char *tags)
+            {
+                const char *tags_end = tags + std::strlen(tags);
+                const char *want = nullptr;
+                const char *want_end = nullptr;
+                while (next_tag(pattern, pattern_end, want, want_end))
+                {
+                    bool found = false;
+                    const char *cursor = tags;
+                    const char *have = nullptr;
+                    const char *have_end = nullptr;
+                    while (!found && next_tag(cursor, tags_end, have, have_end))
+                        found = glob_match(want, want_end, have, have_end);
+                    if (!found)
+                        return false;
+                }
+                return true;
+            }
+
+            std::string m_text;
+            std::vector<Pattern> m_names;
+            std::vector<Pattern> m_names_excluded;
+            std::vector<Pattern> m_files;
+            std::vector<Pattern> m_files_excluded;
+        };
+    } // namespace detail
+} // namespace guard